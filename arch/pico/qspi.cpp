@@ -20,6 +20,7 @@
 #include <pico/stdlib.h>
 #include <hardware/pio.h>
 #include <hardware/dma.h>
+#include <hardware/irq.h>
 #include <hardware/structs/bus_ctrl.h>
 
 #include "qspi.pio.h"
@@ -49,10 +50,27 @@ volatile io_ro_8* get_rx_fifo(PIO pio, uint32_t sm)
     return reinterpret_cast<io_ro_8*>(&pio->rxf[sm]);
 }
 
-static uint32_t qspi_data_program = 0;
 constexpr int default_timeout = 10000;
-static int dma_channel_1 = 0;
-static int dma_channel_2 = 0;
+
+// instances releasing bus when DMA channel finishes, indexed by channel
+const msgpu::Qspi* release_owners[NUM_DMA_CHANNELS] = {};
+
+bool __time_critical_func(is_idle)(PIO pio, uint32_t sm)
+{
+    return pio->sm[sm].addr >= qspi_offset_idle_wait_loop
+        && pio->sm[sm].addr < qspi_offset_idle_wait_end;
+}
+
+void __time_critical_func(release_finished_buses)()
+{
+    for (uint32_t channel = 0; channel < NUM_DMA_CHANNELS; ++channel)
+    {
+        if (release_owners[channel] != nullptr && dma_channel_get_irq0_status(channel))
+        {
+            release_owners[channel]->release_bus();
+        }
+    }
+}
 }
 
 Qspi::Qspi(const QspiConfig config, float clkdiv)
@@ -70,21 +88,30 @@ Qspi::Qspi(const QspiConfig config, float clkdiv)
 
 void Qspi::init() 
 {
-    qspi_data_program = pio_add_program(get_pio(config_.pio), &qspi_program);
+    // program has fixed origin, instances placed on the same PIO share already loaded copy
+    if (pio_can_add_program(get_pio(config_.pio), &qspi_program))
+    {
+        program_offset_ = pio_add_program(get_pio(config_.pio), &qspi_program);
+    }
 
     pio_qspi_init_data(get_pio(config_.pio),
         config_.sm,
-        qspi_data_program,
+        program_offset_,
         clkdiv_,
         config_.io_base,
         config_.sck,
         config_.cs
     );
 
-    dma_channel_1 = dma_claim_unused_channel(true);
-    dma_channel_2 = dma_claim_unused_channel(true);
+    dma_channel_1_ = dma_claim_unused_channel(true);
+    dma_channel_2_ = dma_claim_unused_channel(true);
     bus_ctrl_hw->priority = BUSCTRL_BUS_PRIORITY_DMA_W_BITS | BUSCTRL_BUS_PRIORITY_DMA_R_BITS;
 
+    if (irq_get_exclusive_handler(DMA_IRQ_0) == nullptr)
+    {
+        irq_set_exclusive_handler(DMA_IRQ_0, release_finished_buses);
+    }
+
     release_bus();
 }
 
@@ -139,28 +166,31 @@ void __time_critical_func(Qspi::setup_dma_read)(DataType dest, int channel, int
 
 void __time_critical_func(Qspi::wait_for_finish)() const 
 {
-    dma_channel_wait_for_finish_blocking(dma_channel_1);
-    dma_channel_wait_for_finish_blocking(dma_channel_2);
+    dma_channel_wait_for_finish_blocking(dma_channel_1_);
+    dma_channel_wait_for_finish_blocking(dma_channel_2_);
 }
 
 void Qspi::setup_dma_command_write(ConstDataType cmd, ConstDataType data)
 {
-    setup_dma_write(cmd, dma_channel_1, dma_channel_2);
-    setup_dma_write(data, dma_channel_2);
+    setup_dma_write(cmd, dma_channel_1_, dma_channel_2_);
+    setup_dma_write(data, dma_channel_2_);
 }
 
 void Qspi::setup_dma_command_read(ConstDataType cmd, DataType data)
 {
-    setup_dma_write(cmd, dma_channel_1, dma_channel_2);
-    setup_dma_read(data, dma_channel_2);
+    setup_dma_write(cmd, dma_channel_1_, dma_channel_2_);
+    setup_dma_read(data, dma_channel_2_);
 }
 
 void Qspi::acquire_bus() const
 {
+    cancel_release();
     wait_for_finish();
+    auto pio = get_pio(config_.pio);
+    while (!is_idle(pio, config_.sm)) {}
+
     gpio_put(config_.sync_out, true);
     while (gpio_get(config_.sync_in)) {}
-    auto pio = get_pio(config_.pio);
 
     pio_sm_set_consecutive_pindirs(pio, config_.sm, config_.sck, 1, true);
     pio_sm_set_consecutive_pindirs(pio, config_.sm, config_.cs, 1, true);
@@ -170,10 +200,13 @@ void Qspi::acquire_bus() const
 
 }
 
-void Qspi::release_bus() const
+void __time_critical_func(Qspi::release_bus)() const
 {
+    cancel_release();
     wait_for_finish();
     auto pio = get_pio(config_.pio);
+    // FIFO may be still drained by state machine when DMA is done
+    while (!is_idle(pio, config_.sm)) {}
 
     pio_sm_set_enabled(pio, config_.sm, false);
     pio_sm_set_consecutive_pindirs(pio, config_.sm, config_.sck, 1, false);
@@ -182,6 +215,26 @@ void Qspi::release_bus() const
     gpio_put(config_.sync_out, false);
 }
 
+void Qspi::release_bus_on_finish()
+{
+    release_owners[dma_channel_2_] = this;
+    dma_channel_acknowledge_irq0(dma_channel_2_);
+    dma_channel_set_irq0_enabled(dma_channel_2_, true);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    if (!dma_channel_is_busy(dma_channel_1_) && !dma_channel_is_busy(dma_channel_2_))
+    {
+        // transfer was finished before interrupt was armed
+        release_bus();
+    }
+}
+
+void __time_critical_func(Qspi::cancel_release)() const
+{
+    dma_channel_set_irq0_enabled(dma_channel_2_, false);
+    dma_channel_acknowledge_irq0(dma_channel_2_);
+}
+
 
 bool Qspi::spi_transmit(ConstDataType src, DataType dest)
 {
@@ -303,6 +356,8 @@ bool Qspi::qspi_write(ConstDataType src)
     std::size_t tx_remain = src.size();
 
     wait_until_previous_finished();
+    // single transaction
+    pio_sm_put(pio, config_.sm, 0);
     pio_sm_put(pio, config_.sm, src.size() * 2 - 1);
     pio_sm_exec(pio, config_.sm, pio_encode_jmp(qspi_offset_qspi_w));
 
@@ -328,30 +383,103 @@ bool __time_critical_func(Qspi::qspi_command_read)(DataType command, DataType da
 
     wait_until_previous_finished();
     pio_sm_set_clkdiv(pio, config_.sm, 1.0f);
-    setup_dma_write(command, dma_channel_1, dma_channel_2);
-    setup_dma_read(data, dma_channel_2);
+    setup_dma_write(command, dma_channel_1_, dma_channel_2_);
+    setup_dma_read(data, dma_channel_2_);
 
     pio_sm_set_in_pins(pio, config_.sm, config_.io_base);
     
     pio_sm_put(pio, config_.sm, data.size() * 2 - 1);
 
-    dma_channel_start(dma_channel_1);
+    dma_channel_start(dma_channel_1_);
     pio_sm_exec(pio, config_.sm, pio_encode_jmp(qspi_offset_qspi_command_r));
     return true;
 }
 
 bool __time_critical_func(Qspi::qspi_command_write)(ConstDataType command, ConstDataType data)
 {
-    auto pio = get_pio(config_.sm);
+    const CommandWrite transfer{command, data};
+    return qspi_command_write(std::span<const CommandWrite>(&transfer, 1));
+}
 
+bool __time_critical_func(Qspi::qspi_command_write)(std::span<const CommandWrite> transfers)
+{
+    if (transfers.size() > max_chained_transfers)
+    {
+        return qspi_command_write(transfers.first(max_chained_transfers))
+            && qspi_command_write(transfers.subspan(max_chained_transfers));
+    }
+
+    for (const auto& transfer : transfers)
+    {
+        if (transfer.command.empty())
+        {
+            return false;
+        }
+    }
+
+    if (transfers.empty())
+    {
+        return true;
+    }
+
+    auto pio = get_pio(config_.pio);
+
+    // descriptors of previous chain are used until its last transfer is loaded
     wait_until_previous_finished();
+    dma_channel_wait_for_finish_blocking(dma_channel_1_);
     pio_sm_set_clkdiv(pio, config_.sm, 1.0f);
-    setup_dma_write(command, dma_channel_1, dma_channel_2);
-    setup_dma_write(data, dma_channel_2);
-    const int size = command.size() * 2 + data.size() * 2 - 1;
-    pio_sm_put(pio, config_.sm, size);
 
-    dma_channel_start(dma_channel_1);
+    dma_channel_config data = dma_channel_get_default_config(dma_channel_2_);
+    channel_config_set_read_increment(&data, true);
+    channel_config_set_write_increment(&data, false);
+    channel_config_set_dreq(&data, pio_get_dreq(pio, config_.sm, true));
+    channel_config_set_chain_to(&data, dma_channel_1_);
+    // interrupt is raised only by null descriptor at the end of chain
+    channel_config_set_irq_quiet(&data, true);
+    channel_config_set_transfer_data_size(&data, DMA_SIZE_32);
+    const uint32_t word_ctrl = channel_config_get_ctrl_value(&data);
+    channel_config_set_transfer_data_size(&data, DMA_SIZE_8);
+    const uint32_t byte_ctrl = channel_config_get_ctrl_value(&data);
+
+    const auto fifo = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&pio->txf[config_.sm]));
+    std::size_t count = 0;
+    const auto add_descriptor = [this, fifo, &count](uint32_t ctrl, const void* src,
+        std::size_t size) {
+        if (size != 0)
+        {
+            descriptors_[count++] = DmaDescriptor{
+                .ctrl           = ctrl,
+                .read_addr      = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(src)),
+                .write_addr     = fifo,
+                .transfer_count = static_cast<uint32_t>(size)};
+        }
+    };
+
+    // state machine takes number of transactions, then size of each one before its bytes
+    chain_words_[0] = static_cast<uint32_t>(transfers.size() - 1);
+    add_descriptor(word_ctrl, &chain_words_[0], 1);
+    for (std::size_t i = 0; i < transfers.size(); ++i)
+    {
+        const auto& transfer = transfers[i];
+        chain_words_[i + 1] =
+            static_cast<uint32_t>((transfer.command.size() + transfer.data.size()) * 2 - 1);
+        add_descriptor(word_ctrl, &chain_words_[i + 1], 1);
+        add_descriptor(byte_ctrl, transfer.command.data(), transfer.command.size());
+        add_descriptor(byte_ctrl, transfer.data.data(), transfer.data.size());
+    }
+    // null trigger stops chain and raises interrupt of quiet channel
+    descriptors_[count] =
+        DmaDescriptor{.ctrl = byte_ctrl, .read_addr = 0, .write_addr = 0, .transfer_count = 0};
+
+    dma_channel_config control = dma_channel_get_default_config(dma_channel_1_);
+    channel_config_set_transfer_data_size(&control, DMA_SIZE_32);
+    channel_config_set_read_increment(&control, true);
+    channel_config_set_write_increment(&control, true);
+    // each descriptor rewrites alias 1 registers of data channel, last one triggers it
+    channel_config_set_ring(&control, true, 4);
+    dma_channel_configure(dma_channel_1_, &control, &dma_hw->ch[dma_channel_2_].al1_ctrl,
+        descriptors_, 4, true);
+
     pio_sm_exec(pio, config_.sm, pio_encode_jmp(qspi_offset_qspi_w));
     return true;
 }
@@ -165,6 +165,7 @@ IPS6404Stub::IPS6404Stub(std::string_view name)
     : memory_{}
     , sm_data_{memory_}
     , sm_{sm_data_}
+    , statistics_{}
 {
     printf("Allocating shared memory for: %s\n", name.data());
 
@@ -208,12 +209,14 @@ void IPS6404Stub::init()
 
 void IPS6404Stub::read(const DataType &buf, std::size_t len)
 {
+    count_transfer(0, len);
     sm_.process_event(IPS6404StubSm::evTransmit{
         .src = ConstDataType{}, .dest = buf, .src_len = 0, .dest_len = len});
 }
 
 void IPS6404Stub::write(const ConstDataType &buf, std::size_t len)
 {
+    count_transfer(len, 0);
     sm_.process_event(
         IPS6404StubSm::evTransmit{.src = buf, .dest = DataType{}, .src_len = len, .dest_len = 0});
 }
@@ -221,11 +224,29 @@ void IPS6404Stub::write(const ConstDataType &buf, std::size_t len)
 void IPS6404Stub::transmit(const ConstDataType &src, const DataType &dest, std::size_t write_len,
                            std::size_t read_len)
 {
+    count_transfer(write_len, read_len);
     sm_.process_event(IPS6404StubSm::evTransmit{
         .src = src, .dest = dest, .src_len = write_len, .dest_len = read_len});
     // ::write(out_memory_fd_, src.data(), write_len);
     // ::read(in_memory_fd_, dest.data(), read_len);
 }
 
+const TransferStatistics &IPS6404Stub::statistics() const
+{
+    return statistics_;
+}
+
+void IPS6404Stub::reset_statistics()
+{
+    statistics_ = TransferStatistics{};
+}
+
+void IPS6404Stub::count_transfer(std::size_t write_len, std::size_t read_len)
+{
+    ++statistics_.transactions;
+    statistics_.bytes_written += write_len;
+    statistics_.bytes_read += read_len;
+}
+
 } // namespace stubs
 } // namespace msgpu
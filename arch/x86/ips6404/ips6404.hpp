@@ -178,6 +178,14 @@ private:
     bool reset_enabled_ {false};
 };
 
+/// @brief Traffic seen by stub, used by benchmarks
+struct TransferStatistics
+{
+    std::size_t transactions;
+    std::size_t bytes_written;
+    std::size_t bytes_read;
+};
+
 class IPS6404Stub : public msgpu::IDevice
 {
 private: 
@@ -190,8 +198,13 @@ public:
     void write(const ConstDataType& buf, std::size_t len) override;
     void transmit(const ConstDataType& buf, const DataType& dest, std::size_t write_len, std::size_t read_len) override;
 
+    /// @returns bytes transferred since creation or last reset, including commands
+    const TransferStatistics& statistics() const;
+    void reset_statistics();
+
 private: 
     void get_command();
+    void count_transfer(std::size_t write_len, std::size_t read_len);
 
     int memory_fd_;
     std::string_view name_;
@@ -199,6 +212,7 @@ private:
     SharedMemory memory_;
     IPS6404StubSm sm_data_;
     boost::sml::sm<IPS6404StubSm> sm_;
+    TransferStatistics statistics_;
 };
 
 } // namespace stubs
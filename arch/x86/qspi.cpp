@@ -86,6 +86,15 @@ bool Qspi::qspi_command_write(ConstDataType command, ConstDataType data)
     return true;
 }
 
+bool Qspi::qspi_command_write(std::span<const CommandWrite> transfers)
+{
+    for (const auto &transfer : transfers)
+    {
+        qspi_command_write(transfer.command, transfer.data);
+    }
+    return true;
+}
+
 void Qspi::wait_for_finish() const
 {
 }
@@ -98,4 +107,9 @@ void Qspi::release_bus() const
 {
 }
 
+void Qspi::release_bus_on_finish()
+{
+    release_bus();
+}
+
 } // namespace msgpu
@@ -16,6 +16,17 @@
 
 #include "sync.hpp"
 
+#include <condition_variable>
+#include <cstdint>
+
+namespace
+{
+std::mutex event_mutex;
+std::condition_variable event_signal;
+uint64_t events = 0;
+// each core has own event register
+thread_local uint64_t seen_events = 0;
+} // namespace
 
 void mutex_init(mutex_t* m)
 {
@@ -30,3 +41,19 @@ void mutex_exit(mutex_t* m)
 {
     m->unlock();
 }
+
+void __sev()
+{
+    {
+        std::lock_guard<std::mutex> lock(event_mutex);
+        ++events;
+    }
+    event_signal.notify_all();
+}
+
+void __wfe()
+{
+    std::unique_lock<std::mutex> lock(event_mutex);
+    event_signal.wait(lock, [] { return events != seen_events; });
+    seen_events = events;
+}
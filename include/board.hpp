@@ -53,6 +53,9 @@ void unblock_display();
 
 void initialize_application_specific();
 
+/// @brief Starts function on second core, function must never return
+void run_on_second_core(void (*entry)());
+
 void enable_dump();
 
 void enable_display();
@@ -16,6 +16,7 @@
 
 #pragma once 
 
+#include <cstddef>
 #include <cstdint>
 
 #include <span>
@@ -56,10 +57,34 @@ public:
 
     bool qspi_command_write(ConstDataType command, ConstDataType data);
 
+    /// @brief Command with data sent in single transaction
+    struct CommandWrite
+    {
+        ConstDataType command;
+        ConstDataType data;
+    };
+
+    constexpr static std::size_t max_chained_transfers = 8;
+
+    /// @brief Sends transactions back to back without releasing bus
+    ///
+    /// @details
+    ///   Up to max_chained_transfers transactions are sent by single DMA chain,
+    ///   control channel loads descriptor of each command and data block to data channel,
+    ///   so CPU doesn't wait between them. Longer lists are split into chains.
+    ///   Last chain is not awaited. Buffers must stay valid until wait_for_finish().
+    bool qspi_command_write(std::span<const CommandWrite> transfers);
+
     void wait_for_finish() const;
 
     void acquire_bus() const;
     void release_bus() const;
+
+    /// @brief Releases bus from DMA interrupt as soon as started transfer is finished
+    ///
+    /// @details
+    ///   Pending release is cancelled by acquire_bus() or release_bus().
+    void release_bus_on_finish();
 private:
     void setup_dma_write(ConstDataType src, int channel, int chain_to = -1);
     void setup_dma_read(DataType dest, int channel, int chain_to = -1);
@@ -68,8 +93,27 @@ private:
     void setup_dma_command_read(ConstDataType cmd, DataType data); 
 
     bool wait_until_previous_finished();
+    void cancel_release() const;
+
     const QspiConfig config_;
     const float clkdiv_;
+    // each instance owns its channels, framebuffer and GPU RAM are driven from different cores
+    uint32_t program_offset_ = 0;
+    int dma_channel_1_ = 0;
+    int dma_channel_2_ = 0;
+
+    // layout of DMA channel alias 1 registers, written by control channel
+    struct DmaDescriptor
+    {
+        uint32_t ctrl;
+        uint32_t read_addr;
+        uint32_t write_addr;
+        uint32_t transfer_count;
+    };
+
+    // transactions count, then size, command and data of each transaction and null descriptor
+    DmaDescriptor descriptors_[3 * max_chained_transfers + 2];
+    uint32_t chain_words_[max_chained_transfers + 1];
 };
 
 } // namespace msgpu 
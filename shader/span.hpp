@@ -0,0 +1,45 @@
+/*
+ *   Copyright (c) 2021 Mateusz Stadnik
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Part of shader interface, GPU uses it once msgpu_interface provides shader/span.hpp */
+
+#pragma once
+
+#include <stdint.h>
+
+/* Fragments shaded by single call of pixel shader entry point shade_span.
+ * Colours of pixels x0..x1 (inclusive) of line y are written to output in framebuffer
+ * format (RGB332), one element per pixel. Shader arguments are the same as for main. */
+typedef struct ShaderSpan
+{
+    uint16_t y;
+    uint16_t x0;
+    uint16_t x1;
+    uint16_t *output;
+} ShaderSpan;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* Span processed by current shade_span call, resolved by dynamic linker as shader_gl_Span */
+    extern ShaderSpan *gl_Span;
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,49 @@
+/*
+ *   Copyright (c) 2021 Mateusz Stadnik
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Part of shader interface, GPU uses it once msgpu_interface provides shader/vertex_batch.hpp */
+
+#pragma once
+
+#include <shader/vec3.hpp>
+#include <shader/vec4.hpp>
+
+/* Vertices transformed by single call of vertex shader entry point shade_vertices.
+ * Attributes are stored as structure of arrays, inputs[i] points to first element of
+ * attribute i and consecutive elements are input_sizes[i] bytes apart.
+ * Shader writes count positions and colours, as main does with gl_Position and its output. */
+typedef struct ShaderVertexBatch
+{
+    int count;
+    void **inputs;
+    const int *input_sizes;
+    vec4 *positions;
+    vec3 *colors;
+} ShaderVertexBatch;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /* Batch processed by current shade_vertices call, resolved by dynamic linker as
+     * shader_gl_VertexBatch */
+    extern ShaderVertexBatch *gl_VertexBatch;
+
+#ifdef __cplusplus
+}
+#endif
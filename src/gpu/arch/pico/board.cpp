@@ -18,6 +18,7 @@
 
 #include <cstdio>
 
+#include <pico/multicore.h>
 #include <pico/stdlib.h>
 #include <hardware/clocks.h>
 
@@ -48,5 +49,10 @@ void initialize_board()
     printf("Board initialized\n");
 }
 
+void run_on_second_core(void (*entry)())
+{
+    multicore_launch_core1(entry);
+}
+
 
 } // namespace msgpu
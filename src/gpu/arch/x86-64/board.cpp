@@ -18,6 +18,7 @@
 
 #include <filesystem>
 #include <memory>
+#include <thread>
 
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -107,4 +108,10 @@ void write_bytes(const void *data, std::size_t size)
     write(serial_write_port, data, size);
 }
 
+void run_on_second_core(void (*entry)())
+{
+    // second core is emulated with thread which lives until process exits
+    std::thread(entry).detach();
+}
+
 } // namespace msgpu
@@ -19,13 +19,20 @@
 namespace msgpu::buffers
 {
 
+GpuBuffersBase::GpuBuffersBase()
+    : allocator_()
+    , slabs_(allocator_)
+{
+    entries_.fill(empty_entry);
+}
+
 void GpuBuffersBase::allocate_names(uint32_t amount, uint16_t *ids)
 {
     for (std::size_t i = 0; i < amount; ++i)
     {
         const uint32_t slot = allocate_name();
         ids[i]              = static_cast<uint16_t>(slot);
-        entries_[slot]      = BufferEntry{};
+        entries_[slot]      = empty_entry;
     }
 }
 
@@ -33,84 +40,123 @@ void GpuBuffersBase::release_names(uint32_t amount, uint16_t *ids)
 {
     for (uint32_t i = 0; i < amount; ++i)
     {
+        if (!test(ids[i]))
+        {
+            continue;
+        }
         release_name(ids[i]);
         dealloc(entries_[ids[i]]);
     }
 }
 
-void GpuBuffersBase::allocate_memory(uint32_t id, std::size_t size)
+bool GpuBuffersBase::allocate_memory(uint32_t id, std::size_t size)
 {
-    if (!names_map_.test(id))
+    if (!test(id))
     {
-        return;
+        return false;
     }
 
     auto &entry = entries_[id];
-    if (entry.blocks)
+    if (has_memory(entry))
     {
         dealloc(entry);
     }
 
-    alloc(entry, size);
+    return alloc(entry, size);
+}
+
+void GpuBuffersBase::reserve_memory(std::size_t address, std::size_t size)
+{
+    const std::size_t first_block = address / block_size;
+    const std::size_t last_block  = (address + size + block_size - 1) / block_size;
+    allocator_.reserve(static_cast<uint32_t>(first_block),
+                       static_cast<uint32_t>(last_block - first_block));
 }
 
-uint32_t GpuBuffersBase::find_empty_block(uint32_t size)
+AllocationStatistics GpuBuffersBase::memory_statistics() const
 {
-    uint32_t current_size = 0;
-    uint32_t block_begin  = 0;
+    const AllocationStatistics blocks = allocator_.statistics();
+    return AllocationStatistics{
+        .free         = blocks.free * block_size,
+        .largest_free = blocks.largest_free * block_size,
+        .fragments    = blocks.fragments,
+    };
+}
 
-    for (uint32_t i = 0; i < buffer_size; ++i)
+std::size_t GpuBuffersBase::accessible_size(uint32_t id, std::size_t size,
+                                            std::size_t offset) const
+{
+    if (!test(id) || !has_memory(entries_[id]))
     {
-        if (allocation_map_[i] == 0)
-        {
-            ++current_size;
-            if (current_size == size)
-            {
-                return block_begin;
-            }
-        }
-        else
-        {
-            current_size = 0;
-            block_begin  = i + 1;
-        }
+        return 0;
     }
-    return 0xffffffff;
+
+    const BufferEntry &entry = entries_[id];
+    if (offset + size <= entry.size)
+    {
+        return size;
+    }
+
+    log::Log::error("Access outside of buffer %d: { offset: %d, size: %d, buffer size: %d }", id,
+                    offset, size, entry.size);
+    return offset < entry.size ? entry.size - offset : 0;
 }
 
-void GpuBuffersBase::alloc(BufferEntry &entry, std::size_t size)
+bool GpuBuffersBase::alloc(BufferEntry &entry, std::size_t size)
 {
     if (size == 0)
     {
         printf("Size is 0\n");
-        return;
+        return false;
     }
+
+    if (Slabs::fits(size))
+    {
+        // when all slabs are used, buffer takes whole block
+        const SlabAllocation slot = slabs_.allocate(size);
+        if (slot.slab != Slabs::no_slab)
+        {
+            entry.address = slot.address;
+            entry.size    = static_cast<uint32_t>(size);
+            entry.slab    = slot.slab;
+            log::Log::trace("Allocated slot: { address: 0x%x, slab: %d, size: %d}",
+                            entry.address, entry.slab, size);
+            return true;
+        }
+    }
+
     const uint32_t size_in_blocks =
         static_cast<uint32_t>(size / block_size) + (size % block_size != 0);
-    const uint32_t start_block = find_empty_block(size_in_blocks);
-
-    for (uint32_t i = start_block; i < start_block + size_in_blocks; ++i)
+    const uint32_t start_block = allocator_.allocate(size_in_blocks);
+    if (start_block == allocator_.npos)
     {
-        allocation_map_[i] = 1;
+        const AllocationStatistics statistics = allocator_.statistics();
+        log::Log::error("No memory for buffer: %d blocks, free: %d, largest free: %d",
+                        size_in_blocks, statistics.free, statistics.largest_free);
+        return false;
     }
 
     entry.blocks  = static_cast<uint16_t>(size_in_blocks);
-    entry.address = static_cast<uint16_t>(start_block * block_size);
+    entry.address = static_cast<uint32_t>(start_block * block_size);
+    entry.size    = static_cast<uint32_t>(size);
 
     log::Log::trace("Allocated memory: { address: 0x%x, blocks: %d, size: %d}", entry.address,
                     entry.blocks, entry.blocks * block_size);
+    return true;
 }
 
 void GpuBuffersBase::dealloc(BufferEntry &entry)
 {
-    const uint32_t start_block = entry.address / block_size;
-    for (uint32_t i = start_block; i < start_block + entry.blocks; ++i)
+    if (entry.slab != Slabs::no_slab)
+    {
+        slabs_.release(SlabAllocation{.address = entry.address, .slab = entry.slab});
+    }
+    else
     {
-        allocation_map_[i] = 0;
+        allocator_.release(static_cast<uint32_t>(entry.address / block_size), entry.blocks);
     }
 
-    entry.address = 0;
-    entry.blocks  = 0;
+    entry = empty_entry;
 }
 
 } // namespace msgpu::buffers
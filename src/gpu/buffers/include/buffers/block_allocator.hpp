@@ -0,0 +1,247 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+
+namespace msgpu::buffers
+{
+
+/// @brief Describes free space of allocator, all values are in blocks
+struct AllocationStatistics
+{
+    std::size_t free;
+    std::size_t largest_free;
+    std::size_t fragments; ///< number of separated free ranges
+};
+
+/// @brief First-fit allocator of consecutive blocks
+///
+/// @details
+///   Allocation state is kept in bitmap, one bit per block. Bitmap words are leaves of
+///   tree which stores free prefix, free suffix and longest free range of each subtree,
+///   so first range large enough is found in O(log n) and released ranges are coalesced
+///   without additional work. Blocks are placed at lowest free address, like linear scan did.
+///
+/// @tparam Blocks - number of managed blocks
+template <std::size_t Blocks>
+class BlockAllocator
+{
+  private:
+    using WordType                               = uint32_t;
+    constexpr static std::size_t blocks_per_word = sizeof(WordType) * 8;
+    constexpr static std::size_t words           = Blocks / blocks_per_word;
+
+    static_assert(Blocks % blocks_per_word == 0, "Blocks must fill whole bitmap words");
+    static_assert(std::has_single_bit(words), "Number of bitmap words must be power of two");
+    static_assert(Blocks <= 0xffff, "Free ranges are counted with 16-bit values");
+
+  public:
+    constexpr static uint32_t npos = 0xffffffff;
+
+    BlockAllocator()
+        : map_{}
+        , free_(Blocks)
+    {
+        for (std::size_t i = 0; i < words; ++i)
+        {
+            nodes_[words + i] = leaf_summary(0);
+        }
+        update_parents(words, 2 * words - 1);
+    }
+
+    /// @brief Reserves consecutive blocks
+    ///
+    /// @param blocks - number of blocks
+    ///
+    /// @returns index of first block or npos if there is no free range large enough
+    uint32_t allocate(uint32_t blocks)
+    {
+        if (blocks == 0 || nodes_[1].longest < blocks)
+        {
+            return npos;
+        }
+
+        const uint32_t first = find(blocks);
+        mark(first, blocks, true);
+        return first;
+    }
+
+    /// @brief Marks blocks as used, so they are never allocated
+    void reserve(uint32_t first, uint32_t blocks)
+    {
+        if (blocks == 0 || first >= Blocks)
+        {
+            return;
+        }
+        mark(first, std::min<uint32_t>(blocks, static_cast<uint32_t>(Blocks) - first), true);
+    }
+
+    /// @brief Releases blocks reserved by allocate()
+    void release(uint32_t first, uint32_t blocks)
+    {
+        if (blocks == 0 || first >= Blocks || blocks > Blocks - first)
+        {
+            return;
+        }
+        mark(first, blocks, false);
+    }
+
+    bool is_used(uint32_t block) const
+    {
+        return map_[block / blocks_per_word] >> (block % blocks_per_word) & 1;
+    }
+
+    AllocationStatistics statistics() const
+    {
+        return AllocationStatistics{
+            .free         = free_,
+            .largest_free = nodes_[1].longest,
+            .fragments    = nodes_[1].fragments,
+        };
+    }
+
+  private:
+    struct Node
+    {
+        uint16_t prefix;  // free blocks at beginning
+        uint16_t suffix;  // free blocks at end
+        uint16_t longest; // longest free range
+        uint16_t fragments;
+    };
+
+    static Node leaf_summary(WordType word)
+    {
+        const WordType free = static_cast<WordType>(~word);
+
+        uint16_t longest = 0;
+        for (WordType run = free; run != 0; run &= run >> 1)
+        {
+            ++longest;
+        }
+
+        return Node{
+            .prefix    = static_cast<uint16_t>(std::countr_one(free)),
+            .suffix    = static_cast<uint16_t>(std::countl_one(free)),
+            .longest   = longest,
+            .fragments = static_cast<uint16_t>(std::popcount(free & ~(free << 1))),
+        };
+    }
+
+    /// @returns number of blocks covered by node
+    static std::size_t node_size(std::size_t node)
+    {
+        return Blocks >> (std::bit_width(node) - 1);
+    }
+
+    /// @brief Combines summaries of children, each child covers half blocks
+    static Node merge(const Node &left, const Node &right, uint16_t half)
+    {
+        const uint16_t joined = left.suffix != 0 && right.prefix != 0;
+        const uint16_t across = static_cast<uint16_t>(left.suffix + right.prefix);
+        return Node{
+            .prefix    = left.prefix == half ? static_cast<uint16_t>(half + right.prefix)
+                                             : left.prefix,
+            .suffix    = right.suffix == half ? static_cast<uint16_t>(half + left.suffix)
+                                              : right.suffix,
+            .longest   = std::max({left.longest, right.longest, across}),
+            .fragments = static_cast<uint16_t>(left.fragments + right.fragments - joined),
+        };
+    }
+
+    /// @brief Recalculates nodes above leaves from first to last (inclusive)
+    void update_parents(std::size_t first, std::size_t last)
+    {
+        for (first /= 2, last /= 2; first != 0; first /= 2, last /= 2)
+        {
+            for (std::size_t node = first; node <= last; ++node)
+            {
+                const auto half = static_cast<uint16_t>(node_size(node) / 2);
+                nodes_[node]    = merge(nodes_[2 * node], nodes_[2 * node + 1], half);
+            }
+        }
+    }
+
+    /// @brief Finds lowest free range, tree must contain range large enough
+    uint32_t find(uint32_t blocks) const
+    {
+        std::size_t node  = 1;
+        std::size_t first = 0;
+        while (node < words)
+        {
+            const Node &left       = nodes_[2 * node];
+            const Node &right      = nodes_[2 * node + 1];
+            const std::size_t half = node_size(node) / 2;
+            if (left.longest >= blocks)
+            {
+                node = 2 * node;
+            }
+            else if (left.suffix + right.prefix >= blocks)
+            {
+                return static_cast<uint32_t>(first + half - left.suffix);
+            }
+            else
+            {
+                node  = 2 * node + 1;
+                first += half;
+            }
+        }
+
+        // range is inside of single word, bits which start free range are left
+        const WordType free = static_cast<WordType>(~map_[node - words]);
+        WordType starts     = free;
+        for (uint32_t i = 1; i < blocks; ++i)
+        {
+            starts &= free >> i;
+        }
+        return static_cast<uint32_t>(first + static_cast<std::size_t>(std::countr_zero(starts)));
+    }
+
+    void mark(uint32_t first, uint32_t blocks, bool used)
+    {
+        const std::size_t first_word = first / blocks_per_word;
+        const std::size_t last_word  = (first + blocks - 1) / blocks_per_word;
+        for (std::size_t word = first_word; word <= last_word; ++word)
+        {
+            const std::size_t begin = std::max<std::size_t>(first, word * blocks_per_word);
+            const std::size_t end =
+                std::min<std::size_t>(first + blocks, (word + 1) * blocks_per_word);
+            const std::size_t count = end - begin;
+            const WordType mask =
+                (count == blocks_per_word ? ~WordType{0} : (WordType{1} << count) - 1)
+                << (begin % blocks_per_word);
+
+            const WordType previous = map_[word];
+            map_[word]              = used ? previous | mask : previous & ~mask;
+            const int changed       = std::popcount(static_cast<WordType>(previous ^ map_[word]));
+            free_ = used ? free_ - static_cast<std::size_t>(changed)
+                         : free_ + static_cast<std::size_t>(changed);
+            nodes_[words + word] = leaf_summary(map_[word]);
+        }
+        update_parents(words + first_word, words + last_word);
+    }
+
+    std::array<WordType, words> map_;
+    // 1-based tree, node n has children 2n and 2n + 1, leaves describe bitmap words
+    std::array<Node, 2 * words> nodes_;
+    std::size_t free_;
+};
+
+} // namespace msgpu::buffers
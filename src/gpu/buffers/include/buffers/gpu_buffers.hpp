@@ -17,10 +17,13 @@
 #pragma once
 
 #include <array>
-#include <bitset>
 #include <cstdint>
+#include <cstring>
+#include <span>
 
+#include "buffers/block_allocator.hpp"
 #include "buffers/id_generator.hpp"
+#include "buffers/slab_allocator.hpp"
 #include "memory/gpuram.hpp"
 
 #include "log/log.hpp"
@@ -28,10 +31,13 @@
 namespace msgpu::buffers
 {
 
+/// @brief Memory of buffer, small buffers are placed in slab and don't own blocks
 struct BufferEntry
 {
-    uint16_t address;
+    uint32_t address;
+    uint32_t size; // requested size, slab slot or blocks may be bigger
     uint16_t blocks;
+    uint16_t slab;
 };
 
 class GpuBuffersBase : public IdGenerator<2048>
@@ -39,22 +45,60 @@ class GpuBuffersBase : public IdGenerator<2048>
   protected:
     constexpr static std::size_t block_size  = 1024;
     constexpr static std::size_t buffer_size = 2048;
+    // whole PSRAM is divided into blocks
+    constexpr static std::size_t memory_size   = 8 * 1024 * 1024;
+    constexpr static std::size_t memory_blocks = memory_size / block_size;
+    constexpr static std::size_t max_slabs     = 256;
+
+    using Slabs = SlabAllocator<BlockAllocator<memory_blocks>, block_size, max_slabs>;
+
+    constexpr static BufferEntry empty_entry{
+        .address = 0, .size = 0, .blocks = 0, .slab = Slabs::no_slab};
 
   public:
+    /// @brief Range of buffer read by gather
+    struct BufferRead
+    {
+        uint32_t id;
+        void *data;
+        std::size_t size;
+        std::size_t offset;
+    };
+
+    GpuBuffersBase();
+
     void allocate_names(uint32_t amount, uint16_t *ids);
 
     void release_names(uint32_t amount, uint16_t *ids);
 
-    void allocate_memory(uint32_t id, std::size_t size);
+    /// @brief Allocates memory for buffer, previous memory of buffer is released
+    ///
+    /// @returns false if there is no free memory range large enough, buffer has no memory then
+    bool allocate_memory(uint32_t id, std::size_t size);
     void deallocate_memory(uint32_t id);
 
-  protected:
-    uint32_t find_empty_block(uint32_t size);
+    /// @brief Excludes memory range used by other objects from buffers memory
+    void reserve_memory(std::size_t address, std::size_t size);
+
+    /// @returns free memory statistics in bytes, fragments is number of free ranges
+    AllocationStatistics memory_statistics() const;
 
-    void alloc(BufferEntry &entry, std::size_t size);
+  protected:
+    bool alloc(BufferEntry &entry, std::size_t size);
     void dealloc(BufferEntry &entry);
 
-    std::bitset<buffer_size> allocation_map_;
+    static bool has_memory(const BufferEntry &entry)
+    {
+        return entry.blocks != 0 || entry.slab != Slabs::no_slab;
+    }
+
+    /// @brief Limits accessed range to memory of buffer
+    ///
+    /// @returns number of bytes inside buffer, 0 for unknown buffer or buffer without memory
+    std::size_t accessible_size(uint32_t id, std::size_t size, std::size_t offset) const;
+
+    BlockAllocator<memory_blocks> allocator_;
+    Slabs slabs_;
     std::array<BufferEntry, buffer_size> entries_;
 };
 
@@ -71,31 +115,81 @@ class GpuBuffers : public GpuBuffersBase
     {
     }
 
+    /// @brief Writes data to buffer, data outside of buffer is dropped
     void write(uint32_t id, const void *data, std::size_t size, std::size_t offset = 0)
     {
-        if (!names_map_.test(id))
+        // access outside of buffer would overwrite other buffers
+        const std::size_t length = accessible_size(id, size, offset);
+        if (length == 0)
         {
             return;
         }
 
-        auto &entry = entries_[id];
-
-        memory_.write(entry.address + offset, data, size);
+        memory_.write(entries_[id].address + offset, data, length);
     }
 
+    /// @brief Reads data from buffer, part of data outside of buffer is zeroed
     void read(uint32_t id, void *data, std::size_t size, std::size_t offset = 0)
     {
-        if (!names_map_.test(id))
+        const std::size_t length = accessible_size(id, size, offset);
+        zero_tail(data, size, length);
+        if (length == 0)
         {
             return;
         }
 
-        auto &entry = entries_[id];
+        memory_.read(entries_[id].address + offset, data, length);
+    }
 
-        memory_.read(entry.address + offset, data, size);
+    /// @brief Reads several buffer ranges at once
+    ///
+    /// @details
+    ///   Ranges are passed to memory together, so it can merge them into fewer transfers.
+    ///   Ranges are limited to buffer like in single read.
+    void read(std::span<const BufferRead> reads)
+    {
+        if constexpr (requires { typename MemoryType::ReadRequest; })
+        {
+            typename MemoryType::ReadRequest requests[max_gather];
+            std::size_t count = 0;
+            for (const BufferRead &r : reads)
+            {
+                const std::size_t length = accessible_size(r.id, r.size, r.offset);
+                zero_tail(r.data, r.size, length);
+                if (length == 0)
+                {
+                    continue;
+                }
+
+                requests[count++] = {entries_[r.id].address + r.offset, r.data, length};
+                if (count == max_gather)
+                {
+                    memory_.read(std::span<const typename MemoryType::ReadRequest>(requests));
+                    count = 0;
+                }
+            }
+            memory_.read(std::span<const typename MemoryType::ReadRequest>(requests, count));
+        }
+        else
+        {
+            for (const BufferRead &r : reads)
+            {
+                read(r.id, r.data, r.size, r.offset);
+            }
+        }
     }
 
   private:
+    constexpr static std::size_t max_gather = 16;
+
+    static void zero_tail(void *data, std::size_t size, std::size_t length)
+    {
+        if (length < size)
+        {
+            std::memset(static_cast<uint8_t *>(data) + length, 0, size - length);
+        }
+    }
+
     MemoryType &memory_;
 };
 
@@ -0,0 +1,381 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace msgpu::buffers
+{
+
+enum class WritePolicy : uint8_t
+{
+    WriteThrough,
+    WriteBack,
+};
+
+/// @brief Accesses counted by MemoryCache
+struct CacheStatistics
+{
+    uint32_t read_hits;
+    uint32_t read_misses;
+    uint32_t write_hits;
+    uint32_t write_misses;
+    uint32_t write_backs;
+    uint32_t bypassed;
+};
+
+/// @brief Set-associative cache of external memory placed in internal SRAM
+///
+/// @details
+///   Provides the same read/write interface as memory, so it can be placed between
+///   GpuBuffers and GpuRAM. Each set keeps Ways lines, least recently used one is evicted.
+///   Lines missed by single read are filled together, so memory supporting gather
+///   can merge them into single transfer.
+///   Accesses spanning more lines than sets pass directly to memory, cached lines are kept
+///   coherent, so streaming data doesn't evict lines which are read every frame.
+///   Write-through keeps memory up to date and doesn't allocate lines on write.
+///   Write-back allocates lines on write and stores them when evicted or flushed.
+///   Memory must not be modified past cache, otherwise invalidate() must be called.
+///
+/// @tparam MemoryType - cached memory
+/// @tparam LineSize - size of line in bytes, must be power of two
+/// @tparam Sets - number of sets, must be power of two
+/// @tparam Ways - number of lines in set
+template <typename MemoryType, std::size_t LineSize = 64, std::size_t Sets = 32,
+          std::size_t Ways = 4>
+class MemoryCache
+{
+  public:
+    static_assert(std::has_single_bit(LineSize), "Line size must be power of two");
+    static_assert(std::has_single_bit(Sets), "Number of sets must be power of two");
+    static_assert(Ways != 0, "Set must contain at least one line");
+
+    MemoryCache(MemoryType &memory, WritePolicy policy = WritePolicy::WriteThrough)
+        : memory_(memory)
+        , policy_(policy)
+        , clock_(0)
+        , statistics_{}
+        , lines_{}
+    {
+    }
+
+    std::size_t read(std::size_t address, void *data, std::size_t size)
+    {
+        if (size == 0)
+        {
+            return 0;
+        }
+
+        if (!cacheable(address, size))
+        {
+            ++statistics_.bypassed;
+            flush(address, size);
+            return memory_.read(address, data, size);
+        }
+
+        // each line of range falls into different set, so they don't evict each other
+        fill(address, size);
+        uint8_t *out = static_cast<uint8_t *>(data);
+        for_each_line(address, size,
+                      [this, out](std::size_t line, std::size_t offset, std::size_t from,
+                                  std::size_t length) {
+                          std::memcpy(out + offset, find(line)->data + from, length);
+                      });
+        return size;
+    }
+
+    std::size_t write(std::size_t address, const void *data, std::size_t size)
+    {
+        if (size == 0)
+        {
+            return 0;
+        }
+
+        const uint8_t *in = static_cast<const uint8_t *>(data);
+        if (policy_ == WritePolicy::WriteThrough || !cacheable(address, size))
+        {
+            if (!cacheable(address, size))
+            {
+                ++statistics_.bypassed;
+            }
+            for_each_line(address, size,
+                          [this, in](std::size_t line, std::size_t offset, std::size_t from,
+                                     std::size_t length) {
+                              Line *cached = find(line);
+                              if (cached == nullptr)
+                              {
+                                  ++statistics_.write_misses;
+                                  return;
+                              }
+                              ++statistics_.write_hits;
+                              std::memcpy(cached->data + from, in + offset, length);
+                          });
+            return memory_.write(address, data, size);
+        }
+
+        for_each_line(address, size,
+                      [this, in](std::size_t line, std::size_t offset, std::size_t from,
+                                 std::size_t length) {
+                          Line *cached = find(line);
+                          if (cached != nullptr)
+                          {
+                              ++statistics_.write_hits;
+                          }
+                          else
+                          {
+                              ++statistics_.write_misses;
+                              // whole line is overwritten, so it doesn't have to be read
+                              cached = allocate(line, length != LineSize);
+                          }
+                          std::memcpy(cached->data + from, in + offset, length);
+                          cached->dirty = true;
+                          cached->used  = ++clock_;
+                      });
+        return size;
+    }
+
+    /// @brief Stores dirty lines to memory
+    void flush()
+    {
+        for (Line &line : lines_)
+        {
+            write_back(line);
+        }
+    }
+
+    /// @brief Stores dirty lines overlapping with range to memory
+    void flush(std::size_t address, std::size_t size)
+    {
+        if (policy_ == WritePolicy::WriteThrough)
+        {
+            return;
+        }
+
+        for (Line &line : lines_)
+        {
+            if (overlaps(line, address, size))
+            {
+                write_back(line);
+            }
+        }
+    }
+
+    /// @brief Drops all lines, dirty data is lost, flush() must be called before to keep it
+    void invalidate()
+    {
+        for (Line &line : lines_)
+        {
+            line.valid = false;
+            line.dirty = false;
+        }
+    }
+
+    /// @brief Drops lines overlapping with range, dirty data is lost
+    void invalidate(std::size_t address, std::size_t size)
+    {
+        for (Line &line : lines_)
+        {
+            if (overlaps(line, address, size))
+            {
+                line.valid = false;
+                line.dirty = false;
+            }
+        }
+    }
+
+    WritePolicy policy() const
+    {
+        return policy_;
+    }
+
+    /// @brief Changes write policy, dirty lines are stored when write-through is selected
+    void set_policy(WritePolicy policy)
+    {
+        if (policy == WritePolicy::WriteThrough)
+        {
+            flush();
+        }
+        policy_ = policy;
+    }
+
+    const CacheStatistics &statistics() const
+    {
+        return statistics_;
+    }
+
+    void reset_statistics()
+    {
+        statistics_ = CacheStatistics{};
+    }
+
+    /// @returns percent of reads served from cache
+    uint32_t read_hit_rate() const
+    {
+        const uint32_t reads = statistics_.read_hits + statistics_.read_misses;
+        return reads == 0 ? 0 : static_cast<uint32_t>(statistics_.read_hits * 100ull / reads);
+    }
+
+  private:
+    struct Line
+    {
+        uint32_t tag;
+        uint32_t used;
+        bool valid;
+        bool dirty;
+        uint8_t data[LineSize];
+    };
+
+    /// @brief Calls visitor(line, offset, from, length) for each line crossed by range,
+    ///        offset is position in range, from is position in line
+    template <typename Visitor>
+    static void for_each_line(std::size_t address, std::size_t size, const Visitor &visitor)
+    {
+        std::size_t offset = 0;
+        while (offset < size)
+        {
+            const std::size_t from   = (address + offset) % LineSize;
+            const std::size_t length = std::min(size - offset, LineSize - from);
+            visitor((address + offset) / LineSize, offset, from, length);
+            offset += length;
+        }
+    }
+
+    /// @returns true if lines of range fit into different sets
+    static bool cacheable(std::size_t address, std::size_t size)
+    {
+        return (address + size - 1) / LineSize - address / LineSize < Sets;
+    }
+
+    static std::size_t set_of(std::size_t line)
+    {
+        return line % Sets;
+    }
+
+    static bool overlaps(const Line &line, std::size_t address, std::size_t size)
+    {
+        const std::size_t begin = static_cast<std::size_t>(line.tag) * LineSize;
+        return line.valid && begin < address + size && address < begin + LineSize;
+    }
+
+    Line *find(std::size_t line)
+    {
+        Line *set = &lines_[set_of(line) * Ways];
+        for (std::size_t way = 0; way < Ways; ++way)
+        {
+            if (set[way].valid && set[way].tag == line)
+            {
+                return &set[way];
+            }
+        }
+        return nullptr;
+    }
+
+    /// @brief Replaces least recently used line of set
+    ///
+    /// @param line - index of line in memory
+    /// @param read - true if line must be read from memory
+    Line *allocate(std::size_t line, bool read)
+    {
+        Line *set    = &lines_[set_of(line) * Ways];
+        Line *victim = &set[0];
+        for (std::size_t way = 0; way < Ways && victim->valid; ++way)
+        {
+            if (!set[way].valid || set[way].used < victim->used)
+            {
+                victim = &set[way];
+            }
+        }
+
+        write_back(*victim);
+        victim->tag   = static_cast<uint32_t>(line);
+        victim->valid = true;
+        if (read)
+        {
+            memory_.read(line * LineSize, victim->data, LineSize);
+        }
+        return victim;
+    }
+
+    /// @brief Allocates missed lines of range and reads them from memory together
+    void fill(std::size_t address, std::size_t size)
+    {
+        if constexpr (requires { typename MemoryType::ReadRequest; })
+        {
+            typename MemoryType::ReadRequest requests[Sets];
+            std::size_t count = 0;
+            for_each_line(address, size, [&](std::size_t line, std::size_t, std::size_t,
+                                             std::size_t) {
+                Line *cached = access(line);
+                if (cached == nullptr)
+                {
+                    cached            = allocate(line, false);
+                    cached->used      = clock_;
+                    requests[count++] = {line * LineSize, cached->data, LineSize};
+                }
+            });
+            memory_.read(std::span<const typename MemoryType::ReadRequest>(requests, count));
+        }
+        else
+        {
+            for_each_line(address, size, [this](std::size_t line, std::size_t, std::size_t,
+                                                std::size_t) {
+                if (access(line) == nullptr)
+                {
+                    allocate(line, true)->used = clock_;
+                }
+            });
+        }
+    }
+
+    /// @brief Looks up line for read and updates its statistics
+    Line *access(std::size_t line)
+    {
+        Line *cached = find(line);
+        ++clock_;
+        if (cached == nullptr)
+        {
+            ++statistics_.read_misses;
+            return nullptr;
+        }
+        ++statistics_.read_hits;
+        cached->used = clock_;
+        return cached;
+    }
+
+    void write_back(Line &line)
+    {
+        if (line.valid && line.dirty)
+        {
+            memory_.write(static_cast<std::size_t>(line.tag) * LineSize, line.data, LineSize);
+            line.dirty = false;
+            ++statistics_.write_backs;
+        }
+    }
+
+    MemoryType &memory_;
+    WritePolicy policy_;
+    uint32_t clock_;
+    CacheStatistics statistics_;
+    std::array<Line, Sets * Ways> lines_;
+};
+
+} // namespace msgpu::buffers
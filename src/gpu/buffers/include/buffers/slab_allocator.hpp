@@ -0,0 +1,225 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+
+namespace msgpu::buffers
+{
+
+/// @brief Slot of small buffer inside of slab
+struct SlabAllocation
+{
+    uint32_t address;
+    uint16_t slab;
+};
+
+/// @brief Allocator of small buffers packed into shared blocks
+///
+/// @details
+///   Each slab is single block divided into slots of equal size, sizes are powers of two
+///   from min_slot_size to block_size / 2. Slabs of each size with free slots are linked
+///   together, so allocation and release are O(1). Slab is returned to block allocator
+///   when its last slot is released. Block never crosses memory page, so buffers allocated
+///   together are read from the same page.
+///
+/// @tparam BlockAllocatorType - allocator of blocks, see BlockAllocator
+/// @tparam BlockSize - size of block in bytes
+/// @tparam MaxSlabs - maximal number of slabs used at once
+template <typename BlockAllocatorType, std::size_t BlockSize, std::size_t MaxSlabs>
+class SlabAllocator
+{
+  public:
+    constexpr static std::size_t min_slot_size = 32;
+    constexpr static std::size_t max_slot_size = BlockSize / 2;
+    constexpr static uint16_t no_slab          = 0xffff;
+
+    static_assert(std::has_single_bit(BlockSize), "Block size must be power of two");
+    static_assert(BlockSize / min_slot_size <= 32, "Slots of slab must fit in 32-bit mask");
+    static_assert(MaxSlabs < no_slab, "Slab index must be smaller than no_slab");
+
+    SlabAllocator(BlockAllocatorType &blocks)
+        : blocks_(blocks)
+        , free_slabs_(0)
+    {
+        partial_.fill(no_slab);
+        for (std::size_t i = 0; i < MaxSlabs; ++i)
+        {
+            slabs_[i].next = i + 1 < MaxSlabs ? static_cast<uint16_t>(i + 1) : no_slab;
+        }
+    }
+
+    /// @returns true if buffer of given size is placed in slab
+    constexpr static bool fits(std::size_t size)
+    {
+        return size != 0 && size <= max_slot_size;
+    }
+
+    /// @brief Reserves slot for buffer
+    ///
+    /// @param size - size of buffer, must fit in slot
+    ///
+    /// @returns slot or slot with no_slab index if there is no free memory
+    SlabAllocation allocate(std::size_t size)
+    {
+        const uint8_t size_class = get_size_class(size);
+        uint16_t index           = partial_[size_class];
+        if (index == no_slab)
+        {
+            index = create_slab(size_class);
+            if (index == no_slab)
+            {
+                return SlabAllocation{.address = 0, .slab = no_slab};
+            }
+        }
+
+        Slab &slab     = slabs_[index];
+        const int slot = std::countr_zero(slab.free_slots);
+        slab.free_slots &= slab.free_slots - 1;
+        if (slab.free_slots == 0)
+        {
+            unlink(index);
+        }
+
+        return SlabAllocation{
+            .address = static_cast<uint32_t>(slab.block * BlockSize +
+                                             static_cast<std::size_t>(slot) * slot_size(slab)),
+            .slab    = index,
+        };
+    }
+
+    /// @brief Releases slot returned by allocate()
+    void release(const SlabAllocation &allocation)
+    {
+        if (allocation.slab >= MaxSlabs)
+        {
+            return;
+        }
+
+        Slab &slab             = slabs_[allocation.slab];
+        const std::size_t slot = (allocation.address - slab.block * BlockSize) / slot_size(slab);
+        if (slab.free_slots == 0)
+        {
+            link(allocation.slab);
+        }
+        slab.free_slots |= 1u << slot;
+
+        if (slab.free_slots == all_slots(slab.size_class))
+        {
+            unlink(allocation.slab);
+            blocks_.release(slab.block, 1);
+            slab.next   = free_slabs_;
+            free_slabs_ = allocation.slab;
+        }
+    }
+
+  private:
+    constexpr static std::size_t size_classes =
+        std::bit_width(max_slot_size) - std::bit_width(min_slot_size) + 1;
+
+    struct Slab
+    {
+        uint32_t free_slots; // bit is set for free slot
+        uint16_t block;
+        uint16_t next;
+        uint16_t previous;
+        uint8_t size_class;
+    };
+
+    static uint8_t get_size_class(std::size_t size)
+    {
+        const std::size_t slot = std::max(std::bit_ceil(size), min_slot_size);
+        return static_cast<uint8_t>(std::bit_width(slot) - std::bit_width(min_slot_size));
+    }
+
+    static std::size_t slot_size(const Slab &slab)
+    {
+        return min_slot_size << slab.size_class;
+    }
+
+    static uint32_t all_slots(uint8_t size_class)
+    {
+        const std::size_t slots = BlockSize / (min_slot_size << size_class);
+        return slots == 32 ? 0xffffffff : (1u << slots) - 1;
+    }
+
+    uint16_t create_slab(uint8_t size_class)
+    {
+        if (free_slabs_ == no_slab)
+        {
+            return no_slab;
+        }
+
+        const uint32_t block = blocks_.allocate(1);
+        if (block == blocks_.npos)
+        {
+            return no_slab;
+        }
+
+        const uint16_t index = free_slabs_;
+        Slab &slab           = slabs_[index];
+        free_slabs_          = slab.next;
+        slab.block           = static_cast<uint16_t>(block);
+        slab.free_slots      = all_slots(size_class);
+        slab.size_class      = size_class;
+        link(index);
+        return index;
+    }
+
+    /// @brief Adds slab to list of slabs with free slots
+    void link(uint16_t index)
+    {
+        Slab &slab     = slabs_[index];
+        uint16_t &head = partial_[slab.size_class];
+        slab.previous  = no_slab;
+        slab.next      = head;
+        if (head != no_slab)
+        {
+            slabs_[head].previous = index;
+        }
+        head = index;
+    }
+
+    void unlink(uint16_t index)
+    {
+        Slab &slab = slabs_[index];
+        if (slab.previous == no_slab)
+        {
+            partial_[slab.size_class] = slab.next;
+        }
+        else
+        {
+            slabs_[slab.previous].next = slab.next;
+        }
+
+        if (slab.next != no_slab)
+        {
+            slabs_[slab.next].previous = slab.previous;
+        }
+    }
+
+    BlockAllocatorType &blocks_;
+    std::array<Slab, MaxSlabs> slabs_{};
+    // first slab with free slots for each size class
+    std::array<uint16_t, size_classes> partial_;
+    uint16_t free_slabs_;
+};
+
+} // namespace msgpu::buffers
@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <array>
+#include <bitset>
 #include <cstdint>
 
 #include "buffers/id_generator.hpp"
@@ -23,27 +25,45 @@
 namespace msgpu::buffers
 {
 
-struct VertexArrayBufferData
-{
-    uint8_t size       : 7;
-    uint8_t normalized : 1;
-    uint8_t type;
-    uint16_t index;
-    uint16_t stride;
-};
-
-template <typename MemoryType, std::size_t buffer_size>
+/// @brief Vertex array objects with state kept in SRAM
+///
+/// @details
+///   States of recently bound arrays are resident in SRAM slots, slot of array is found
+///   through lookup table, so binding resident array doesn't touch memory.
+///   State is written back to memory only when its slot is reused by other array
+///   and state was modified since it was loaded. Array which was never written back
+///   starts with default constructed state, so new arrays are not read from memory.
+///
+/// @tparam MemoryType - memory where evicted states are stored
+/// @tparam buffer_size - maximal number of arrays
+/// @tparam StateType - state of single array, must be trivially copyable
+/// @tparam resident_size - number of states kept in SRAM
+template <typename MemoryType, std::size_t buffer_size, typename StateType,
+          std::size_t resident_size = 16>
 class VertexArrayBuffer : public IdGenerator<buffer_size>
 {
   private:
-    constexpr static inline std::size_t structure_size = sizeof(VertexArrayBufferData);
+    constexpr static inline std::size_t structure_size = sizeof(StateType);
+    constexpr static inline uint8_t no_slot             = 0xff;
+
+    static_assert(resident_size != 0 && resident_size < no_slot, "Slot index must fit in byte");
 
   public:
     constexpr static inline std::size_t start_address = 0x100000;
+    /// @brief Size of memory used by all vertex arrays
+    constexpr static inline std::size_t memory_size = structure_size * buffer_size;
 
     VertexArrayBuffer(MemoryType &memory)
         : memory_(memory)
+        , clock_(0)
+        , stored_{}
+        , slots_{}
     {
+        slot_of_.fill(no_slot);
+        for (auto &slot : slots_)
+        {
+            slot.array = no_array;
+        }
     }
 
     void allocate_names(uint32_t amount, uint16_t *ids)
@@ -59,47 +79,137 @@ class VertexArrayBuffer : public IdGenerator<buffer_size>
     {
         for (uint32_t i = 0; i < amount; ++i)
         {
+            if (!this->test(ids[i]))
+            {
+                continue;
+            }
+
+            // state of released array is dropped without write-back
+            const uint8_t slot = slot_of_[ids[i]];
+            if (slot != no_slot)
+            {
+                slots_[slot].array = no_array;
+                slots_[slot].dirty = false;
+                slot_of_[ids[i]]   = no_slot;
+            }
+            stored_.reset(ids[i]);
             this->release_name(ids[i]);
         }
     }
 
-    VertexArrayBufferData get(uint16_t index) const
+    /// @brief Makes state of array resident
+    ///
+    /// @returns state which stays valid until other array is bound, nullptr for unknown array
+    const StateType *bind(uint16_t index)
+    {
+        Slot *slot = resident(index);
+        return slot == nullptr ? nullptr : &slot->state;
+    }
+
+    /// @brief Returns state of array for modification, state is written back lazily
+    ///
+    /// @returns state which stays valid until other array is bound, nullptr for unknown array
+    StateType *modify(uint16_t index)
     {
-        VertexArrayBufferData data{};
-        if (index >= buffer_size)
+        Slot *slot = resident(index);
+        if (slot == nullptr)
         {
-            return data;
+            return nullptr;
         }
+        slot->dirty = true;
+        return &slot->state;
+    }
 
-        if (!this->test(index))
+    /// @brief Writes back all modified states
+    void flush()
+    {
+        for (auto &slot : slots_)
         {
-            return data;
+            write_back(slot);
         }
+    }
 
-        memory_.read(start_address + structure_size * index, &data, structure_size);
+  private:
+    constexpr static inline uint16_t no_array = 0xffff;
 
-        return data;
-    }
+    struct Slot
+    {
+        StateType state;
+        uint32_t used;
+        uint16_t array;
+        bool dirty;
+    };
 
-    bool set(uint16_t index, const VertexArrayBufferData &data)
+    Slot *resident(uint16_t index)
     {
-        if (index >= buffer_size)
+        if (!this->test(index))
         {
-            return false;
+            return nullptr;
         }
 
-        if (!this->test(index))
+        ++clock_;
+        const uint8_t resident_slot = slot_of_[index];
+        if (resident_slot != no_slot)
         {
-            return false;
+            slots_[resident_slot].used = clock_;
+            return &slots_[resident_slot];
         }
 
-        memory_.write(start_address + structure_size * index, &data, structure_size);
-        return true;
+        uint8_t victim = 0;
+        for (uint8_t i = 0; i < resident_size; ++i)
+        {
+            if (slots_[i].array == no_array)
+            {
+                victim = i;
+                break;
+            }
+            if (slots_[i].used < slots_[victim].used)
+            {
+                victim = i;
+            }
+        }
+
+        Slot &slot = slots_[victim];
+        write_back(slot);
+        if (slot.array != no_array)
+        {
+            slot_of_[slot.array] = no_slot;
+        }
+
+        if (stored_.test(index))
+        {
+            memory_.read(start_address + structure_size * index, &slot.state, structure_size);
+        }
+        else
+        {
+            slot.state = StateType{};
+        }
+        slot.array      = index;
+        slot.used       = clock_;
+        slot.dirty      = false;
+        slot_of_[index] = victim;
+        return &slot;
+    }
+
+    void write_back(Slot &slot)
+    {
+        if (slot.array != no_array && slot.dirty)
+        {
+            memory_.write(start_address + structure_size * slot.array, &slot.state,
+                          structure_size);
+            stored_.set(slot.array);
+            slot.dirty = false;
+        }
     }
 
   protected:
     MemoryType &memory_;
+
+  private:
+    uint32_t clock_;
+    std::bitset<buffer_size> stored_;
+    std::array<uint8_t, buffer_size> slot_of_;
+    std::array<Slot, resident_size> slots_;
 };
 
 } // namespace msgpu::buffers
-
@@ -18,17 +18,44 @@
 
 #include <array>
 #include <cstdint>
+#include <span>
 
 #include "messages/header.hpp"
 
 namespace msgpu::io 
 {
 
+/// @brief Destination of data received in bulk frame
+enum class BulkKind : uint8_t
+{
+    None        = 0,
+    BufferData  = 1,
+    ProgramData = 2,
+};
+
 struct Message 
 {
     bool received; 
     Header header; 
     std::array<uint8_t, 32> payload;
+    bool windowed                      = false;
+    uint8_t sequence                   = 0;
+    BulkKind bulk                      = BulkKind::None;
+    std::span<const uint8_t> bulk_data = {};
+};
+
+/// @brief Block of buffer data received in bulk frame, continues WriteBufferData stream
+struct BufferDataBlock
+{
+    constexpr static BulkKind kind = BulkKind::BufferData;
+    std::span<const uint8_t> data;
+};
+
+/// @brief Block of program binary received in bulk frame, continues ProgramWrite stream
+struct ProgramDataBlock
+{
+    constexpr static BulkKind kind = BulkKind::ProgramData;
+    std::span<const uint8_t> data;
 };
 
 } // namespace msgpu::io
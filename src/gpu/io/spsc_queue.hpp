@@ -0,0 +1,118 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace msgpu::io
+{
+
+/// @brief Lock-free ring for single producer and single consumer
+///
+/// @details
+///   Elements are constructed in place. Producer fills slot returned by acquire()
+///   and makes it visible with commit(), not committed slot is reused by next acquire().
+///   Consumer works on element returned by front() and releases it with pop(),
+///   so element is never copied out of the ring.
+///
+/// @tparam T - stored element type
+/// @tparam Size - number of slots, must be power of two
+template <typename T, std::size_t Size>
+class SpscQueue
+{
+  public:
+    static_assert(Size != 0 && (Size & (Size - 1)) == 0, "Size must be power of two");
+
+    /// @brief Returns slot which will be published with next commit()
+    ///
+    /// @returns pointer to free slot or nullptr if queue is full
+    T *acquire()
+    {
+        const std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) == Size)
+        {
+            return nullptr;
+        }
+        return &slots_[tail & mask];
+    }
+
+    /// @brief Publishes slot returned by last acquire()
+    void commit()
+    {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /// @brief Copies element to queue
+    ///
+    /// @returns false if queue is full
+    bool push(const T &element)
+    {
+        T *slot = acquire();
+        if (slot == nullptr)
+        {
+            return false;
+        }
+        *slot = element;
+        commit();
+        return true;
+    }
+
+    /// @brief Returns oldest published element
+    ///
+    /// @returns pointer to element or nullptr if queue is empty
+    T *front()
+    {
+        const std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        return &slots_[head & mask];
+    }
+
+    /// @brief Releases element returned by front()
+    void pop()
+    {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool empty() const
+    {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    std::size_t size() const
+    {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    constexpr static std::size_t capacity()
+    {
+        return Size;
+    }
+
+  private:
+    constexpr static std::size_t mask = Size - 1;
+
+    std::array<T, Size> slots_{};
+    std::atomic<std::size_t> head_{0};
+    std::atomic<std::size_t> tail_{0};
+};
+
+} // namespace msgpu::io
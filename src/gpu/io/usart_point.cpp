@@ -25,33 +25,205 @@
 namespace msgpu::io
 {
 
-constexpr uint8_t start_token = 0x7e;
+constexpr uint8_t start_token          = 0x7e;
+constexpr uint8_t windowed_start_token = 0x7d;
+constexpr uint8_t link_control_token   = 0x7b;
+constexpr uint8_t bulk_start_token     = 0x7c;
+
+const Message *UsartPoint::peek()
+{
+    bulk_released_.store(bulk_released_.load(std::memory_order_relaxed) + bulk_consumed_,
+                         std::memory_order_release);
+    bulk_consumed_ = 0;
+
+    report_errors();
+    send_link_control();
+    return messages_.front();
+}
+
+void UsartPoint::consume()
+{
+    release_front(false);
+}
 
 std::optional<Message> UsartPoint::pop()
 {
-    if (!messages_.empty())
+    const Message *front = peek();
+    if (front == nullptr)
+    {
+        return {};
+    }
+
+    Message msg = *front;
+    release_front(true);
+    return msg;
+}
+
+void UsartPoint::release_front(bool keep_block)
+{
+    const Message *msg = messages_.front();
+    if (msg == nullptr)
     {
-        if (messages_.front().received)
+        return;
+    }
+
+    const bool bulk        = msg->bulk != BulkKind::None;
+    const bool windowed    = msg->windowed;
+    const uint8_t sequence = msg->sequence;
+    messages_.pop();
+
+    if (bulk)
+    {
+        if (keep_block)
+        {
+            ++bulk_consumed_;
+        }
+        else
+        {
+            increment(bulk_released_);
+        }
+    }
+
+    if (windowed)
+    {
+        last_consumed_ = sequence;
+        ++unacknowledged_;
+        // host waits for free bulk blocks, so they are confirmed immediately
+        if (unacknowledged_ >= ack_interval || messages_.empty() || bulk)
         {
-            Message msg = messages_.front();
-            messages_.pop_front();
-            return msg;
+            ack_requested_ = true;
+            send_link_control();
         }
     }
-    return {};
+}
+
+void UsartPoint::send_link_control()
+{
+    const uint8_t nak_requests = nak_requests_.load(std::memory_order_acquire);
+    if (nak_requests != naks_sent_)
+    {
+        naks_sent_ = nak_requests;
+        write_link_control(LinkControl::Nak, expected_sequence_.load(std::memory_order_relaxed));
+    }
+
+    const uint8_t ack_requests = ack_requests_.load(std::memory_order_acquire);
+    if (ack_requests != acks_requested_by_peer_)
+    {
+        acks_requested_by_peer_ = ack_requests;
+        ack_requested_          = true;
+    }
+
+    if (ack_requested_)
+    {
+        ack_requested_  = false;
+        unacknowledged_ = 0;
+        write_link_control(LinkControl::Ack, last_consumed_);
+    }
+}
+
+void UsartPoint::write_link_control(LinkControl type, uint8_t sequence)
+{
+    const uint8_t control[] = {static_cast<uint8_t>(type), sequence};
+    const uint16_t crc      = calculate_crc16(std::span<const uint8_t>(control));
+    const uint8_t frame[]   = {link_control_token, control[0], control[1],
+                               static_cast<uint8_t>(crc), static_cast<uint8_t>(crc >> 8)};
+    lock_writes();
+    write_bytes(frame);
+    unlock_writes();
+}
+
+bool UsartPoint::accept_sequence(uint8_t sequence)
+{
+    const uint8_t distance =
+        static_cast<uint8_t>(sequence - expected_sequence_.load(std::memory_order_relaxed));
+    if (distance == 0)
+    {
+        increment(expected_sequence_);
+        retransmission_requested_ = false;
+        return true;
+    }
+
+    if (distance < 0x80)
+    {
+        // frame was lost, host goes back to first missing one
+        if (!retransmission_requested_)
+        {
+            retransmission_requested_ = true;
+            increment(nak_requests_);
+        }
+    }
+    else
+    {
+        // duplicate, host didn't get acknowledgement
+        increment(ack_requests_);
+    }
+    return false;
 }
 
 // ACTIONS
 
+void UsartPoint::begin_message()
+{
+    current_message_ = messages_.acquire();
+    if (current_message_ == nullptr)
+    {
+        // frame is still received to keep synchronization, but it will be dropped
+        current_message_ = &overflow_message_;
+    }
+    *current_message_ = {};
+}
+
 void UsartPoint::prepare_for_header()
 {
     hal::reset_dma_crc();
-    messages_.push_back({});
-    current_message_ = &messages_.back();
+    begin_message();
     hal::set_usart_dma_buffer(&current_message_->header, false);
     hal::set_usart_dma_transfer_count(sizeof(Header), true);
 }
 
+void UsartPoint::prepare_for_sequence()
+{
+    begin_message();
+    current_message_->windowed = true;
+    hal::set_usart_dma_buffer(&current_message_->sequence, false);
+    hal::set_usart_dma_transfer_count(sizeof(current_message_->sequence), true);
+}
+
+void UsartPoint::prepare_for_windowed_header()
+{
+    hal::set_usart_dma_buffer(&current_message_->header, false);
+    hal::set_usart_dma_transfer_count(sizeof(Header), true);
+}
+
+void UsartPoint::prepare_for_bulk_header()
+{
+    begin_message();
+    current_message_->windowed = true;
+    hal::set_usart_dma_buffer(&bulk_header_, false);
+    hal::set_usart_dma_transfer_count(sizeof(BulkHeader), true);
+}
+
+void UsartPoint::prepare_for_bulk_header_crc()
+{
+    const auto *header         = reinterpret_cast<const uint8_t *>(&bulk_header_);
+    current_message_->sequence = bulk_header_.sequence;
+    current_message_->bulk     = bulk_header_.kind;
+    expected_crc_ = calculate_crc16(std::span<const uint8_t>(header, sizeof(BulkHeader)));
+    hal::set_usart_dma_buffer(&received_crc_, false);
+    hal::set_usart_dma_transfer_count(sizeof(received_crc_), true);
+}
+
+void UsartPoint::prepare_for_bulk_payload()
+{
+    hal::reset_dma_crc();
+    auto &block = bulk_buffers_[bulk_next_];
+    bulk_next_  = (bulk_next_ + 1) % bulk_blocks;
+    increment(bulk_allocated_);
+    current_message_->bulk_data = std::span<const uint8_t>(block.data(), bulk_header_.size);
+    hal::set_usart_dma_buffer(block.data(), false);
+    hal::set_usart_dma_transfer_count(bulk_header_.size, true);
+}
+
 void UsartPoint::prepare_for_token()
 {
     hal::set_usart_dma_buffer(&token_buffer_, false);
@@ -72,20 +244,96 @@ void UsartPoint::prepare_for_crc()
     hal::set_usart_dma_transfer_count(sizeof(received_crc_), true);
 }
 
+void UsartPoint::prepare_for_header_crc()
+{
+    if (!current_message_->windowed)
+    {
+        prepare_for_crc();
+        return;
+    }
+
+    uint8_t header[sizeof(current_message_->sequence) + sizeof(Header)];
+    header[0] = current_message_->sequence;
+    std::memcpy(&header[1], &current_message_->header, sizeof(Header));
+    expected_crc_ = calculate_crc16(std::span<const uint8_t>(header));
+    hal::set_usart_dma_buffer(&received_crc_, false);
+    hal::set_usart_dma_transfer_count(sizeof(received_crc_), true);
+}
+
 void UsartPoint::store_message()
 {
+    if (current_message_ == &overflow_message_)
+    {
+        count_error(QueueOverflow);
+        drop_message();
+        return;
+    }
+
+    if (current_message_->windowed && !accept_sequence(current_message_->sequence))
+    {
+        release_current_block();
+        return;
+    }
     current_message_->received = true;
+    messages_.commit();
     // printf("Acking %d\n", current_message_->payload.at(0));
     // write(Ack{});
 }
 
 void UsartPoint::drop_message()
 {
-    messages_.pop_back();
+    if (current_message_->windowed && !retransmission_requested_)
+    {
+        retransmission_requested_ = true;
+        increment(nak_requests_);
+    }
+    release_current_block();
     // printf("Drop -> ACK\n");
     // write(Ack{});
 }
 
+void UsartPoint::release_current_block()
+{
+    if (current_message_->bulk_data.empty())
+    {
+        return;
+    }
+    // only last allocated block may be rejected
+    bulk_next_ = (bulk_next_ + bulk_blocks - 1) % bulk_blocks;
+    bulk_allocated_.store(bulk_allocated_.load(std::memory_order_relaxed) - 1,
+                          std::memory_order_release);
+}
+
+std::size_t UsartPoint::bulk_used() const
+{
+    return bulk_allocated_.load(std::memory_order_acquire) -
+           bulk_released_.load(std::memory_order_acquire);
+}
+
+void UsartPoint::count_error(ReceiveError error)
+{
+    increment(receive_errors_[error]);
+}
+
+void UsartPoint::report_errors()
+{
+    constexpr const char *names[ReceiveErrorsCount] = {
+        "CRC verification failed",
+        "Message queue overflow, frame dropped",
+        "Bulk frame rejected",
+    };
+
+    for (std::size_t i = 0; i < ReceiveErrorsCount; ++i)
+    {
+        const uint32_t errors = receive_errors_[i].load(std::memory_order_acquire);
+        if (errors != reported_errors_[i])
+        {
+            log::Log::error("%s, count: %d", names[i], errors - reported_errors_[i]);
+            reported_errors_[i] = errors;
+        }
+    }
+}
+
 // GUARDS
 
 bool UsartPoint::got_start_token()
@@ -93,12 +341,21 @@ bool UsartPoint::got_start_token()
     return token_buffer_ == start_token;
 }
 
+bool UsartPoint::got_windowed_start_token()
+{
+    return token_buffer_ == windowed_start_token;
+}
+
+bool UsartPoint::got_bulk_start_token()
+{
+    return token_buffer_ == bulk_start_token;
+}
+
 bool UsartPoint::verify_crc()
 {
     if (expected_crc_ != received_crc_)
     {
-        log::Log::error("CRC verification failed, expected: 0x%x, got: 0x%x", expected_crc_,
-                        received_crc_);
+        count_error(CrcMismatch);
         return false;
     }
     return true;
@@ -114,4 +371,17 @@ bool UsartPoint::check_header()
     return current_message_->header.size <= 32;
 }
 
+bool UsartPoint::check_bulk_header()
+{
+    const bool known_kind = bulk_header_.kind == BulkKind::BufferData ||
+                            bulk_header_.kind == BulkKind::ProgramData;
+    if (!known_kind || bulk_header_.size == 0 || bulk_header_.size > bulk_block_size)
+    {
+        count_error(BulkRejected);
+        return false;
+    }
+    // rejected frame is retransmitted after NAK, when host gets acknowledgements
+    return bulk_used() < bulk_blocks;
+}
+
 } // namespace msgpu::io
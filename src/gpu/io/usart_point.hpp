@@ -17,18 +17,20 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
 #include <optional>
 
 #include <boost/sml.hpp>
 
-#include <eul/container/static_deque.hpp>
 #include <eul/crc/crc.hpp>
 
 #include "board.hpp"
+#include "sync.hpp"
 
 #include "io/message.hpp"
+#include "io/spsc_queue.hpp"
 
 namespace msgpu::io
 {
@@ -40,6 +42,17 @@ struct dma_finished
 {
 };
 
+/// @brief Link control frames sent to host in windowed mode
+///
+/// @details
+///   Ack confirms all frames up to sequence (inclusive), which were consumed.
+///   Nak requests retransmission of all frames starting from sequence.
+enum class LinkControl : uint8_t
+{
+    Ack = 0x06,
+    Nak = 0x15,
+};
+
 /// @brief Implements external world interface with standard USART protocol
 ///
 /// @details
@@ -47,6 +60,11 @@ struct dma_finished
 ///  Received data is validated, but retransmission of frames is not supported.
 ///  Performance is more desirable than reliability.
 ///  Frames are limited to 32 bytes.
+///  State machine is driven from DMA completion (producer), while peek() and consume()
+///  are called from main loop (consumer), received messages are passed via lock-free ring.
+///  Every variable shared by both contexts has single writer and is accessed only with
+///  plain loads and stores, Cortex-M0+ has no atomic read-modify-write instructions.
+///  Errors detected in DMA completion are counted and logged from peek().
 ///  Protocol uses little endian byte order.
 ///  Frames format:
 ///  +--------------+
@@ -69,27 +87,70 @@ struct dma_finished
 ///  |              |
 ///  +--------------+
 ///
+///  Bulk frames (0x7c token) carry up to bulk_block_size bytes of buffer data or program
+///  binary, which are received directly into one of bulk blocks. Bulk frames are sequenced
+///  like windowed frames, so they are acknowledged and retransmitted in the same way.
+///  +--------------+
+///  |     0x7c     |  1 - byte
+///  +--------------+
+///  |   sequence   |  2 - byte
+///  +--------------+
+///  |     kind     |  3 - byte
+///  +--------------+
+///  |              |  4 - byte
+///  +     size     +
+///  |              |  5 - byte
+///  +--------------+
+///  |              |  6 - byte
+///  +  CRC16-CCIT  +
+///  |              |  7 - byte
+///  +--------------+
+///  |              |
+///  .    payload   .  1 - bulk_block_size bytes
+///  |              |
+///  +--------------+
+///  |              |
+///  +  CRC16-CCIT  +  2 bytes
+///  |              |
+///  +--------------+
+///
 /// @author Mateusz Stadnik
 class UsartPoint
 {
     using Self = UsartPoint;
 
   public:
+    UsartPoint()
+    {
+        mutex_init(&write_mutex_);
+    }
+
     auto operator()()
     {
         using namespace boost::sml;
 
-        auto const got_frame_start = wrap(&Self::got_start_token);
-        auto const verify          = wrap(&Self::verify_crc);
-        auto const empty_message   = wrap(&Self::message_without_size);
-        auto const verify_header   = wrap(&Self::check_header);
+        auto const got_frame_start    = wrap(&Self::got_start_token);
+        auto const got_windowed_start = wrap(&Self::got_windowed_start_token);
+        auto const got_bulk_start     = wrap(&Self::got_bulk_start_token);
+        auto const verify             = wrap(&Self::verify_crc);
+        auto const empty_message      = wrap(&Self::message_without_size);
+        auto const verify_header      = wrap(&Self::check_header);
+        auto const verify_bulk_header = wrap(&Self::check_bulk_header);
         return make_transition_table(
             *"init"_s + event<init> / (&Self::prepare_for_token) = "wait_for_start_token"_s,
             "wait_for_start_token"_s + event<dma_finished>[got_frame_start] /
                                            (&Self::prepare_for_header) = "wait_for_header"_s,
-            "wait_for_start_token"_s + event<dma_finished>[!got_frame_start] /
-                                           (&Self::prepare_for_token) = "wait_for_start_token"_s,
-            "wait_for_header"_s + event<dma_finished> / (&Self::prepare_for_crc) =
+            "wait_for_start_token"_s + event<dma_finished>[got_windowed_start] /
+                                           (&Self::prepare_for_sequence) = "wait_for_sequence"_s,
+            "wait_for_start_token"_s + event<dma_finished>[got_bulk_start] /
+                                           (&Self::prepare_for_bulk_header) =
+                "wait_for_bulk_header"_s,
+            "wait_for_start_token"_s +
+                event<dma_finished>[!got_frame_start && !got_windowed_start && !got_bulk_start] /
+                    (&Self::prepare_for_token) = "wait_for_start_token"_s,
+            "wait_for_sequence"_s + event<dma_finished> / (&Self::prepare_for_windowed_header) =
+                "wait_for_header"_s,
+            "wait_for_header"_s + event<dma_finished> / (&Self::prepare_for_header_crc) =
                 "wait_for_header_crc"_s,
             "wait_for_header_crc"_s +
                 event<dma_finished>[verify && verify_header && !empty_message] /
@@ -100,8 +161,19 @@ class UsartPoint
             "wait_for_header_crc"_s + event<dma_finished>[!verify || !verify_header] /
                                           (wrap(&Self::drop_message), &Self::prepare_for_token) =
                 "wait_for_start_token"_s,
+            "wait_for_bulk_header"_s + event<dma_finished> / (&Self::prepare_for_bulk_header_crc) =
+                "wait_for_bulk_header_crc"_s,
+            "wait_for_bulk_header_crc"_s + event<dma_finished>[verify && verify_bulk_header] /
+                                               (&Self::prepare_for_bulk_payload) =
+                "wait_for_bulk_payload"_s,
+            "wait_for_bulk_header_crc"_s +
+                event<dma_finished>[!verify || !verify_bulk_header] /
+                    (wrap(&Self::drop_message), &Self::prepare_for_token) =
+                "wait_for_start_token"_s,
             "wait_for_payload"_s + event<dma_finished> / (&Self::prepare_for_crc) =
                 "wait_for_payload_crc"_s,
+            "wait_for_bulk_payload"_s + event<dma_finished> / (&Self::prepare_for_crc) =
+                "wait_for_payload_crc"_s,
             "wait_for_payload_crc"_s + event<dma_finished>[verify] /
                                            (wrap(&Self::store_message), &Self::prepare_for_token) =
                 "wait_for_start_token"_s,
@@ -110,13 +182,55 @@ class UsartPoint
                 "wait_for_start_token"_s);
     }
 
-    /// @brief Provide access to ready messages
+    /// @brief Maximal number of windowed frames sent by host without acknowledgement
+    ///
+    /// @details
+    ///   Frames are acknowledged when they are consumed, so window must fit in message queue.
+    constexpr static std::size_t window_size = 16;
+
+    /// @brief Number of consumed windowed frames confirmed with single Ack
+    constexpr static std::size_t ack_interval = 4;
+
+    /// @brief Maximal payload size of bulk frame
+    constexpr static std::size_t bulk_block_size = 2048;
+
+    /// @brief Number of bulk frames which may be stored at once
+    ///
+    /// @details
+    ///   Block of message taken with pop() is released on next peek() or pop(), so host may
+    ///   keep at most bulk_blocks - 1 bulk frames without acknowledgement.
+    constexpr static std::size_t bulk_blocks = 4;
+
+    /// @brief Provide access to oldest ready message without copying it
+    ///
+    /// @details
+    ///   Message stays in slot filled by DMA until consume() is called.
+    ///   Pending link control frames for windowed mode are sent from here,
+    ///   so they never interleave with messages written by processing code.
+    ///
+    /// @return pointer to message or nullptr if queue is empty
+    const Message *peek();
+
+    /// @brief Releases message returned by peek(), including its bulk block
+    ///
+    /// @details
+    ///   In windowed mode Ack is sent every ack_interval consumed frames and when queue is
+    ///   drained.
+    void consume();
+
+    /// @brief Copies oldest ready message out of queue
+    ///
+    /// @details
+    ///   Data of bulk message stays valid until next call to peek() or pop().
+    ///
     /// @return Message object if it's ready to process or none if queue is empty
     std::optional<Message> pop();
 
+    /// @brief Sends message to host, may be called from any core
     template <typename T>
     void write(const T &msg)
     {
+        lock_writes();
         Header header;
         header.id   = T::id;
         header.size = sizeof(T);
@@ -138,12 +252,34 @@ class UsartPoint
         constexpr uint8_t start_flag = 0x7e;
         write_bytes(&start_flag, sizeof(start_flag));
         write_bytes(data);
+        unlock_writes();
     }
 
   private:
+    struct BulkHeader
+    {
+        uint8_t sequence;
+        BulkKind kind;
+        uint16_t size;
+    };
+    static_assert(sizeof(BulkHeader) == 4, "Bulk header must match frame layout");
+
+    /// @brief Errors detected in DMA interrupt, they are logged from main loop
+    enum ReceiveError : uint8_t
+    {
+        CrcMismatch,
+        QueueOverflow,
+        BulkRejected,
+        ReceiveErrorsCount,
+    };
+
     // ==================== GUARDS ==================//
     /// @brief Checks if token buffer contains 0x7e, which is symbol for frame start.
     bool got_start_token();
+    /// @brief Checks if token buffer contains 0x7d, which starts frame with sequence number.
+    bool got_windowed_start_token();
+    /// @brief Checks if token buffer contains 0x7c, which starts bulk frame.
+    bool got_bulk_start_token();
     /// @brief Checks if CRC received from peer is same as calculated one.
     bool verify_crc();
     /// @brief Checks if message contains only header (id, without any payload).
@@ -152,6 +288,9 @@ class UsartPoint
     /// @brief Checks if payload size is correct (<=32 bytes)
     bool check_header();
 
+    /// @brief Checks if bulk frame is known kind, fits in block and free block is available
+    bool check_bulk_header();
+
     // =================== ACTIONS ==================//
 
     /// @brief Setup DMA controller to fetch header from usart.
@@ -163,6 +302,25 @@ class UsartPoint
     ///
     void prepare_for_header();
 
+    /// @brief Setup DMA controller to fetch sequence number of windowed frame.
+    ///
+    /// @details
+    ///  Sequence is followed by header, both are protected with header CRC.
+    ///
+    void prepare_for_sequence();
+
+    /// @brief Setup DMA controller to fetch header of windowed frame.
+    void prepare_for_windowed_header();
+
+    /// @brief Setup DMA controller to fetch header of bulk frame.
+    void prepare_for_bulk_header();
+
+    /// @brief Setup DMA controller to fetch bulk header CRC from peer.
+    void prepare_for_bulk_header_crc();
+
+    /// @brief Setup DMA controller to fetch bulk payload directly into free bulk block.
+    void prepare_for_bulk_payload();
+
     /// @brief Setup DMA controller to fetch single byte.
     ///
     /// @details
@@ -191,6 +349,14 @@ class UsartPoint
     ///
     void prepare_for_crc();
 
+    /// @brief Setup DMA controller to fetch header CRC from peer.
+    ///
+    /// @details
+    ///   CRC of windowed frame covers also sequence number received in separate transfer,
+    ///   so it is calculated in software.
+    ///
+    void prepare_for_header_crc();
+
     /// @brief Store received message in message queue
     ///
     /// @details
@@ -203,12 +369,83 @@ class UsartPoint
     /// @brief Drop message from buffer in case of failure.
     void drop_message();
 
+    /// @brief Accepts only next expected sequence, out of order frames are dropped.
+    bool accept_sequence(uint8_t sequence);
+
+    void send_link_control();
+    void write_link_control(LinkControl type, uint8_t sequence);
+
+    /// @brief Serializes frames written by main loop and by render core
+    void lock_writes()
+    {
+        mutex_enter_blocking(&write_mutex_);
+    }
+
+    void unlock_writes()
+    {
+        mutex_exit(&write_mutex_);
+    }
+
+    /// @brief Returns bulk block of message which wasn't accepted.
+    void release_current_block();
+
+    /// @brief Takes queue slot to which next frame is received.
+    void begin_message();
+
+    /// @brief Removes front message, bulk block may be kept until next peek().
+    void release_front(bool keep_block);
+
+    /// @brief Returns number of bulk blocks which are not released by consumer.
+    std::size_t bulk_used() const;
+
+    /// @brief Increments counter which is written only by one context.
+    template <typename T>
+    static void increment(std::atomic<T> &counter)
+    {
+        counter.store(static_cast<T>(counter.load(std::memory_order_relaxed) + 1),
+                      std::memory_order_release);
+    }
+
+    /// @brief Counts error detected in DMA interrupt, logging is left for main loop.
+    void count_error(ReceiveError error);
+
+    /// @brief Logs errors counted since previous report.
+    void report_errors();
+
     uint8_t token_buffer_;
     uint16_t expected_crc_;
     uint16_t received_crc_;
     Message *current_message_;
     uint8_t write_buffer_[128];
-    eul::container::static_deque<Message, 32> messages_;
+    mutex_t write_mutex_;
+    // filled directly by DMA, frames received when queue is full go to overflow_message_
+    SpscQueue<Message, 32> messages_;
+    Message overflow_message_;
+    static_assert(window_size < decltype(messages_)::capacity(),
+                  "Window must fit in message queue");
+
+    // windowed mode state, requests are counted in DMA interrupt and handled in peek()
+    std::atomic<uint8_t> expected_sequence_{0};
+    uint8_t last_consumed_{0xff};
+    std::size_t unacknowledged_{0};
+    std::atomic<uint8_t> nak_requests_{0};
+    std::atomic<uint8_t> ack_requests_{0};
+    uint8_t naks_sent_{0};
+    uint8_t acks_requested_by_peer_{0};
+    bool ack_requested_{false};
+    bool retransmission_requested_{false};
+
+    // bulk blocks are used in FIFO order, consumed block is released on next pop()
+    // allocated is written only in DMA interrupt, released only in main loop
+    BulkHeader bulk_header_;
+    std::array<std::array<uint8_t, bulk_block_size>, bulk_blocks> bulk_buffers_;
+    std::size_t bulk_next_{0};
+    std::atomic<std::size_t> bulk_allocated_{0};
+    std::atomic<std::size_t> bulk_released_{0};
+    std::size_t bulk_consumed_{0};
+
+    std::array<std::atomic<uint32_t>, ReceiveErrorsCount> receive_errors_{};
+    std::array<uint32_t, ReceiveErrorsCount> reported_errors_{};
 };
 
 } // namespace msgpu::io
@@ -25,6 +25,7 @@
 
 #include "board.hpp"
 #include "hal_dma.hpp"
+#include "sync.hpp"
 
 #include "messages/allocate_program.hpp"
 #include "messages/attach_shader.hpp"
@@ -68,6 +69,7 @@
 //#include "io/usart_point.hpp"
 
 #include "mode/3d_graphic_mode.hpp"
+#include "mode/render_core.hpp"
 #include "mode/text_mode.hpp"
 
 #include "modes/graphic/320x240_256.hpp"
@@ -83,7 +85,7 @@
 #include "arch/qspi_config.hpp"
 #include "symbol_codes.h"
 
-#include <condition_variable>
+#include <atomic>
 
 #include "memory/psram.hpp"
 #include <ctime>
@@ -107,6 +109,8 @@ namespace msgpu
 {
 
 static msos::dl::DynamicLinker dynamic_linker;
+// rasterizes frames on second core, while main loop processes messages of next frame
+static mode::RenderCore render_core;
 // static processor::MessageProcessor proc;
 // static io::UsartPoint usart_io_data;
 // static boost::sml::sm<io::UsartPoint> usart_io(usart_io_data);
@@ -124,6 +128,12 @@ void register_handler(auto &proc)
     register_specific_handler<MessageType>(proc, modes);
 }
 
+template <typename BlockType>
+void register_bulk_handler(auto &proc)
+{
+    proc.template register_bulk_handler<BlockType>(&decltype(modes)::process<BlockType>, &modes);
+}
+
 template <typename MessageType>
 void register_specific_handler(auto &proc, auto &handler)
 {
@@ -169,25 +179,40 @@ void register_messages(auto &proc)
     register_handler<SwapBuffer>(proc);
     register_handler<DrawTriangle>(proc);
     register_handler<GenerateNamesRequest>(proc);
+#if MSGPU_DELETE_NAMES_MESSAGE
+    register_handler<DeleteNamesRequest>(proc);
+#endif
     register_handler<WriteBufferData>(proc);
     register_handler<BindObject>(proc);
     register_handler<PrepareForData>(proc);
     register_handler<DrawArrays>(proc);
+#if MSGPU_DRAW_ELEMENTS_MESSAGE
+    register_handler<DrawElements>(proc);
+#endif
+#if MSGPU_FACE_CULLING_MESSAGE
+    register_handler<SetFaceCulling>(proc);
+#endif
     register_handler<ProgramWrite>(proc);
     register_handler<BeginProgramWrite>(proc);
     register_handler<AllocateProgramRequest>(proc);
     register_handler<AttachShader>(proc);
     register_handler<UseProgram>(proc);
+#if MSGPU_CONSTANT_PIXEL_SHADER_MESSAGE
+    register_handler<SetConstantPixelShader>(proc);
+#endif
     register_handler<SetVertexAttrib>(proc);
     register_handler<GetNamedParameterIdReq>(proc);
     register_handler<PrepareForParameterData>(proc);
+    register_bulk_handler<msgpu::io::BufferDataBlock>(proc);
+    register_bulk_handler<msgpu::io::ProgramDataBlock>(proc);
 };
 
+// frames are received in DMA completion handler, main loop sleeps until next completion
+// completions are written only by handler, SEV wakes up main loop waiting in WFE
 struct ControlUsart
 {
-    std::mutex mutex;
-    std::condition_variable cv;
-    std::atomic<bool> trigger;
+    boost::sml::sm<msgpu::io::UsartPoint> &usart_io;
+    std::atomic<uint32_t> completions{0};
 };
 
 int main()
@@ -218,14 +243,20 @@ int main()
     printf("** I2C initialized **\n");
     boost::sml::sm<msgpu::io::UsartPoint> usart_io(usart_io_data);
 
-    ControlUsart c;
+    ControlUsart c{.usart_io = usart_io};
     hal::set_usart_handler([&c]() {
-        c.trigger = true;
-        c.cv.notify_all();
+        c.usart_io.process_event(msgpu::io::dma_finished{});
+        c.completions.store(c.completions.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_release);
+        __sev();
     });
 
     printf("** GPU/IO initialized\n");
-    modes.switch_to<DualBuffered3DGraphic_320x240_256>(framebuffer, gpuram, i2c, usart_io_data);
+    msgpu::run_on_second_core([] { msgpu::render_core.run(); });
+    printf("** Render core started\n");
+
+    modes.switch_to<DualBuffered3DGraphic_320x240_256>(framebuffer, gpuram, i2c, usart_io_data,
+                                                       &msgpu::render_core);
 
     printf("** Switched to default mode\n");
 
@@ -255,7 +286,7 @@ int main()
             {
                 modes.switch_to<DualBufferedTextMode_80x30_16>(
                     handler_deps.framebuffer, handler_deps.gpuram, handler_deps.i2c,
-                    handler_deps.usart_io_data);
+                    handler_deps.usart_io_data, &msgpu::render_core);
             }
         }
     };
@@ -269,23 +300,16 @@ int main()
     printf("** Initialization finished **\n");
     while (true)
     {
+        // completion after this point wakes up wait below
+        const uint32_t completions = c.completions.load(std::memory_order_acquire);
+        while (const msgpu::io::Message *message = usart_io_data.peek())
         {
-            std::unique_lock lk(c.mutex);
-            if (!c.trigger)
-            {
-                // std::this_thread::sleep_for(std::chrono::microseconds(10));
-                if (!c.cv.wait_for(lk, std::chrono::microseconds(100),
-                                   [&c] { return c.trigger.load(); }))
-                    continue;
-            }
-            c.trigger = false;
+            proc.process_message(*message);
+            usart_io_data.consume();
         }
-
-        usart_io.process_event(msgpu::io::dma_finished{});
-        auto message = usart_io_data.pop();
-        if (message)
+        while (c.completions.load(std::memory_order_acquire) == completions)
         {
-            proc.process_message(*message);
+            __wfe();
         }
     }
 }
@@ -17,22 +17,31 @@
 #pragma once
 
 #include <cmath>
+#include <limits>
 
-#include <eul/container/static_deque.hpp>
+#include <eul/container/static_vector.hpp>
 
 #include <msos/dynamic_linker/dynamic_linker.hpp>
 #include <msos/dynamic_linker/environment.hpp>
 
-#include <shader/globals.hpp>
-#include <shader/vec3.hpp>
-#include <shader/vec4.hpp>
-
+#include "mode/active_edge_table.hpp"
+#include "mode/edge_arithmetic.hpp"
 #include "mode/mode_base.hpp"
 #include "mode/programs.hpp"
+#include "mode/shader_interface.hpp"
 #include "mode/vertex.hpp"
 
 #include "symbol_codes.h"
 
+// SetConstantPixelShader is defined in messages/set_constant_pixel_shader.th, it is handled once
+// msgpu_interface generates it
+#if __has_include("messages/set_constant_pixel_shader.hpp")
+#include "messages/set_constant_pixel_shader.hpp"
+#define MSGPU_CONSTANT_PIXEL_SHADER_MESSAGE 1
+#else
+#define MSGPU_CONSTANT_PIXEL_SHADER_MESSAGE 0
+#endif
+
 extern "C"
 {
     void **in_argument[shader_in_arguments_size];
@@ -41,6 +50,12 @@ extern "C"
     void *out_argument_pointer[shader_out_arguments_size];
     vec4 gl_Position;
     vec4 gl_Color;
+#if MSGPU_SHADER_SPAN
+    ShaderSpan *gl_Span = nullptr;
+#endif
+#if MSGPU_SHADER_VERTEX_BATCH
+    ShaderVertexBatch *gl_VertexBatch = nullptr;
+#endif
     vec3 arg;
     int default_argument = 0;
 }
@@ -48,23 +63,46 @@ extern "C"
 namespace msgpu::mode
 {
 
+/// @brief Depth plane of depth tested triangle, z = z_origin + dzdx * x + dzdy * y
+struct depth_plane
+{
+    float z_origin;
+    float dzdx;
+    float dzdy;
+};
+
+/// @brief Triangle prepared for scanline walking
+///
+/// @details
+///   Colour is not stored, primitives without per-pixel shading are filled with colour
+///   evaluated once per frame. Depth plane is stored only for depth tested triangles.
+///
+/// @tparam Edge - arithmetic used for edges stepping
+template <typename Edge>
 struct prepared_triangle
 {
-    float dx1;
-    float dx2;
-    float dx3;
-    float sx;
-    float ex;
+    using Type = typename Edge::Type;
+
+    constexpr static uint16_t no_depth_plane = std::numeric_limits<uint16_t>::max();
+
+    Type dx1;
+    Type dx2;
+    Type dx3;
+    Type sx;
+    Type ex;
     uint16_t min_y;
     uint16_t mid_y;
     uint16_t max_y;
-    uint16_t color;
+    // index in depth planes of display list or no_depth_plane
+    uint16_t depth_plane;
 };
 
 struct Triangle
 {
     uint16_t color;
     vertex_2d v[3];
+    float z[3]      = {};
+    bool depth_test = false;
 };
 
 template <typename Configuration, typename I2CType>
@@ -72,8 +110,13 @@ class GraphicMode2D : public ModeBase<Configuration, I2CType>
 {
   public:
     GraphicMode2D(memory::VideoRam &framebuffer, memory::GpuRAM &gpuram, I2CType &i2c,
-                  io::UsartPoint &point)
-        : ModeBase<Configuration, I2CType>(framebuffer, gpuram, i2c, point)
+                  io::UsartPoint &point, RenderCore *render_core = nullptr)
+        : ModeBase<Configuration, I2CType>(framebuffer, gpuram, i2c, point, render_core)
+        , used_program_(nullptr)
+        , list_programs_{}
+        , last_frame_program_(nullptr)
+        , render_program_(nullptr)
+        , flat_color_(0)
     {
         for (int i = 0; i < shader_in_arguments_size; ++i)
         {
@@ -89,90 +132,146 @@ class GraphicMode2D : public ModeBase<Configuration, I2CType>
         out_argument_pointer[0] = &gl_Color;
     }
 
+    ~GraphicMode2D() override
+    {
+        // render core may still use display lists
+        Base::wait_for_render();
+    }
+
     using Base = ModeBase<Configuration, I2CType>;
     using Base::ModeBase;
     using Base::process;
 
+    using Edge             = EdgeArithmetic<Configuration>;
+    using EdgeType         = typename Edge::Type;
+    using PreparedTriangle = prepared_triangle<Edge>;
+
     void add_triangle(Triangle t)
     {
         sort_triangle(t);
 
-        if (triangles_.size() == triangles_.max_size())
+        auto &triangles = triangles_[Base::build_list_];
+        auto &planes    = depth_planes_[Base::build_list_];
+        if (triangles.size() == triangles.max_size() ||
+            (t.depth_test && planes.size() == planes.max_size()))
         {
             return;
         }
-        triangles_.emplace_back();
+        triangles.emplace_back();
 
-        prepared_triangle &p = triangles_.back();
-        const float dyba     = t.v[1].y - t.v[0].y;
-        const float dyca     = t.v[2].y - t.v[0].y;
-        const float dycb     = t.v[2].y - t.v[1].y;
-        const float dxba     = t.v[1].x - t.v[0].x;
-        const float dxca     = t.v[2].x - t.v[0].x;
-        const float dxcb     = t.v[2].x - t.v[1].x;
+        PreparedTriangle &p = triangles.back();
+        const int dyba      = t.v[1].y - t.v[0].y;
+        const int dyca      = t.v[2].y - t.v[0].y;
+        const int dycb      = t.v[2].y - t.v[1].y;
+        const int dxba      = t.v[1].x - t.v[0].x;
+        const int dxca      = t.v[2].x - t.v[0].x;
+        const int dxcb      = t.v[2].x - t.v[1].x;
 
-        if (std::abs(dyba) > 0)
-            p.dx1 = dxba / dyba;
-        else
-            p.dx1 = dxba;
-        if (std::abs(dyca) > 0)
-            p.dx2 = dxca / dyca;
-        else
-            p.dx2 = dxca;
-        if (std::abs(dycb) > 0)
-            p.dx3 = dxcb / dycb;
-        else
-            p.dx3 = dxcb;
+        p.dx1 = Edge::slope(dxba, dyba);
+        p.dx2 = Edge::slope(dxca, dyca);
+        p.dx3 = Edge::slope(dxcb, dycb);
 
         // move a little to round correctly
-        p.sx = t.v[0].x + 0.0001f;
-        p.ex = (t.v[0].y < t.v[1].y ? t.v[0].x : t.v[1].x) - 0.0001f;
+        p.sx = Edge::from_int(t.v[0].x) + Edge::epsilon;
+        p.ex = Edge::from_int(t.v[0].y < t.v[1].y ? t.v[0].x : t.v[1].x) - Edge::epsilon;
         if (t.v[2].y < t.v[1].y)
         {
             std::swap(p.dx1, p.dx2);
         }
-        p.color = t.color;
-        p.min_y = t.v[0].y;
-        p.mid_y = std::min(t.v[1].y, t.v[2].y);
-        p.max_y = std::max(t.v[1].y, t.v[2].y);
+        p.min_y       = t.v[0].y;
+        p.mid_y       = std::min(t.v[1].y, t.v[2].y);
+        p.max_y       = std::max(t.v[1].y, t.v[2].y);
+        p.depth_plane = PreparedTriangle::no_depth_plane;
+        if (t.depth_test)
+        {
+            p.depth_plane = static_cast<uint16_t>(planes.size());
+            planes.push_back(prepare_depth(t));
+        }
+
+        edge_table_[Base::build_list_].insert(
+            static_cast<typename EdgeTable::IndexType>(triangles.size() - 1), p.min_y);
+        Base::mark_lines(p.min_y, p.max_y, triangle_signature(t));
     }
 
-    void render() override
+    void clear() override
+    {
+        reset_display_list();
+    }
+
+  protected:
+    /// @brief Renders display list to framebuffer
+    ///
+    /// @details
+    ///   Only lines which differ from content of framebuffer are rasterized,
+    ///   lines equal to the ones in front buffer are copied from it.
+    void render_frame() override
     {
+        Base::begin_frame();
+        render_program_ = list_programs_[Base::render_list_];
+        // shader output depends on uniforms, which are not part of line signature
+        const bool shaders_used = render_program_ && render_program_->pixel_shader();
+        // shader inputs are the same for all primitives, so flat colour is evaluated once
+        flat_color_ = has_per_pixel_shading() ? 0 : shade_flat();
         for (uint16_t line = 0; line < Configuration::resolution_height; ++line)
         {
-            std::memset(Base::line_buffer_.u8, this->clear_color_, sizeof(Base::line_buffer_));
-
-            for (auto &triangle : triangles_)
+            if (shaders_used && Base::has_primitives(line))
+            {
+                Base::invalidate_line(line);
+            }
+            else if (Base::has_primitives(line))
             {
-                draw_triangle_line(line, triangle);
+                Base::mix_render_state(line, flat_color_);
             }
-            Base::framebuffer_.write_line(line, Base::line_buffer_.u16);
 
-            while (triangles_.size())
+            switch (Base::line_source(line))
             {
-                if (line > triangles_.front().max_y)
-                {
-                    triangles_.pop_front();
-                }
-                else
-                {
-                    break;
-                }
+            case Base::LineSource::BackBuffer:
+                skip_line(line);
+                break;
+            case Base::LineSource::FrontBuffer:
+                Base::copy_line(line);
+                skip_line(line);
+                break;
+            case Base::LineSource::Render:
+                render_line(line);
+                break;
             }
         }
+    }
 
-        if (!triangles_.empty())
-        {
-            std::abort();
-        }
-        // printf("Render finished\n");
+    /// @brief Remembers program used by display list
+    void prepare_frame() override
+    {
+        list_programs_[Base::build_list_] = used_program_;
+        last_frame_program_               = used_program_;
     }
 
-    void clear()
+    /// @brief Clears triangles of build display list
+    ///
+    /// @details
+    ///   Edges are stepped during rendering, so triangles can't be reused.
+    void reset_display_list() override
     {
-        triangles_.clear();
+        triangles_[Base::build_list_].clear();
+        depth_planes_[Base::build_list_].clear();
+        edge_table_[Base::build_list_].clear();
+        Base::reset_display_list();
     }
+
+    /// @brief Waits until shader globals are not used by render core
+    ///
+    /// @details
+    ///   Shaders exchange data through global arguments, so shaders can't be executed
+    ///   on parse core while frame which uses program is rendered.
+    void wait_for_shaders()
+    {
+        if (last_frame_program_)
+        {
+            Base::wait_for_render();
+        }
+    }
+
+  public:
     void process(const BeginProgramWrite &msg)
     {
         log::Log::trace("Received program transmission start, size: %d, pid: %d", msg.size,
@@ -186,26 +285,12 @@ class GraphicMode2D : public ModeBase<Configuration, I2CType>
     {
         // log::Log::trace("Received program part: %d, current size: %d", msg.part,
         // program_write_index_);
-        std::copy(std::begin(msg.data), std::begin(msg.data) + msg.size,
-                  program_data_.begin() + program_write_index_);
-        program_write_index_ += msg.size;
-
-        if (program_write_index_ == program_data_.size())
-        {
-            log::Log::trace("Received program: %d", program_position_);
-            static msos::dl::Environment env{
-                msos::dl::SymbolAddress{SymbolCode::libc_printf, &printf},
-            };
-
-            static msos::dl::DynamicLinker linker;
-            eul::error::error_code ec;
-
-            const auto *module = linker.load_module(
-                std::span<const uint8_t>(program_data_.data(), program_data_.size()),
-                msos::dl::LoadingModeCopyText, env, ec);
+        write_program_data(std::span<const uint8_t>(msg.data, msg.size));
+    }
 
-            programs_.add_shader(program_position_, module);
-        }
+    void process(const io::ProgramDataBlock &block)
+    {
+        write_program_data(block.data);
     }
 
     void process(const AllocateProgramRequest &req)
@@ -238,21 +323,51 @@ class GraphicMode2D : public ModeBase<Configuration, I2CType>
             .program_id = program_id,
         };
 
-        this->point_.write(resp);
+        this->respond(resp);
     }
 
     void process(const UseProgram &req)
     {
         log::Log::trace("Using program: %d", req.program_id);
+        wait_for_shaders();
         used_program_ = programs_.get(req.program_id);
     }
 
     void process(const AttachShader &req)
     {
         log::Log::trace("Assign shader %d to program %d", req.shader_id, req.program_id);
+        wait_for_shaders();
         programs_.assign_module(req.program_id, req.shader_id);
     }
 
+#if MSGPU_CONSTANT_PIXEL_SHADER_MESSAGE
+    void process(const SetConstantPixelShader &req)
+    {
+        set_constant_pixel_shader(req.program_id, req.constant != 0);
+    }
+#endif // MSGPU_CONSTANT_PIXEL_SHADER_MESSAGE
+
+    /// @brief Marks pixel shader of program as constant for whole primitive
+    ///
+    /// @param program_id - allocated program
+    /// @param constant - true if pixel shader is evaluated once per primitive
+    ///
+    /// @returns false if program is not allocated
+    bool set_constant_pixel_shader(uint8_t program_id, bool constant)
+    {
+        Program *program = programs_.get(program_id);
+        if (program == nullptr)
+        {
+            log::Log::error("Program %d is not allocated", program_id);
+            return false;
+        }
+
+        log::Log::trace("Program %d constant pixel shader: %d", program_id, constant);
+        wait_for_shaders();
+        program->set_constant_pixel_shader(constant);
+        return true;
+    }
+
   protected:
     constexpr uint8_t to_rgb332(float r, float g, float b)
     {
@@ -261,100 +376,351 @@ class GraphicMode2D : public ModeBase<Configuration, I2CType>
                                     static_cast<uint8_t>(roundf(b * 3)));
     }
 
-    void draw_horizontal_line(uint16_t x0, uint16_t x1, uint16_t color)
+    /// @returns true if pixel shader must be executed for each pixel
+    bool has_per_pixel_shading() const
+    {
+        return render_program_ && render_program_->pixel_shader() &&
+               !render_program_->constant_pixel_shader();
+    }
+
+    /// @brief Evaluates colour for primitives without per-pixel shading
+    ///
+    /// @details
+    ///   Constant pixel shader is executed once, without pixel shader
+    ///   current gl_Color is used.
+    uint16_t shade_flat()
+    {
+        if (render_program_ && render_program_->pixel_shader())
+        {
+            out_argument_pointer[0] = &gl_Color;
+            render_program_->pixel_shader()->execute();
+        }
+        return to_rgb332(gl_Color.x, gl_Color.y, gl_Color.z);
+    }
+
+    /// @brief Limits span to screen
+    ///
+    /// @returns false if span is outside of screen
+    static bool clip_span(uint16_t &x0, uint16_t &x1)
     {
-        static_cast<void>(color);
         if (x0 > x1)
             std::swap(x0, x1);
-        if (x0 >= Configuration::resolution_width || x1 >= Configuration::resolution_width)
+        if (x0 >= Configuration::resolution_width)
+        {
+            return false;
+        }
+        x1 = std::min(x1, static_cast<uint16_t>(Configuration::resolution_width - 1));
+        return true;
+    }
+
+    void draw_horizontal_line(uint16_t line, uint16_t x0, uint16_t x1, uint16_t color)
+    {
+        if (!clip_span(x0, x1))
         {
             return;
         }
 
-        for (std::size_t i = x0; i <= x1; ++i)
+        draw_span(line, x0, x1, color);
+    }
+
+    /// @brief Draws span with early depth test
+    ///
+    /// @details
+    ///   Depth is interpolated along span, hidden fragments are rejected
+    ///   before pixel shader. Visible runs are drawn as separate spans.
+    void draw_depth_tested_line(uint16_t line, uint16_t x0, uint16_t x1, const depth_plane &plane)
+    {
+        if (!clip_span(x0, x1))
         {
-            out_argument_pointer[0] = &gl_Color;
-            if (used_program_ && used_program_->pixel_shader())
+            return;
+        }
+
+        float z = plane.z_origin + plane.dzdx * x0 + plane.dzdy * line;
+        std::size_t run_start = x0;
+        bool visible          = false;
+        for (std::size_t x = x0; x <= x1; ++x, z += plane.dzdx)
+        {
+            if (Base::depth_test(x, z))
             {
-                used_program_->pixel_shader()->execute();
+                if (!visible)
+                {
+                    run_start = x;
+                    visible   = true;
+                }
+            }
+            else if (visible)
+            {
+                draw_span(line, static_cast<uint16_t>(run_start), static_cast<uint16_t>(x - 1),
+                          flat_color_);
+                visible = false;
             }
+        }
+
+        if (visible)
+        {
+            draw_span(line, static_cast<uint16_t>(run_start), x1, flat_color_);
+        }
+    }
+
+    void draw_span(uint16_t line, uint16_t x0, uint16_t x1, uint16_t color)
+    {
+        if (!has_per_pixel_shading())
+        {
+            Base::fill_span(x0, x1, color);
+            return;
+        }
+
+        shade_span(line, x0, x1);
+    }
+
+    /// @brief Executes pixel shader for span
+    ///
+    /// @details
+    ///   Span is passed with single call when shader exports shade_span,
+    ///   otherwise main is executed for each pixel.
+    void shade_span(uint16_t line, uint16_t x0, uint16_t x1)
+    {
+#if MSGPU_SHADER_SPAN
+        if (Program::SpanShader *span_shader = render_program_->span_shader())
+        {
+            ShaderSpan span{
+                .y      = line,
+                .x0     = x0,
+                .x1     = x1,
+                .output = &Base::line_buffer_.u16[x0],
+            };
+            gl_Span = &span;
+            span_shader();
+            gl_Span = nullptr;
+            return;
+        }
+#else
+        static_cast<void>(line);
+#endif
 
-            Base::line_buffer_.u16[i] = to_rgb332(gl_Color.x, gl_Color.y, gl_Color.z);
+        const auto *shader      = render_program_->pixel_shader();
+        out_argument_pointer[0] = &gl_Color;
+        for (std::size_t x = x0; x <= x1; ++x)
+        {
+            shader->execute();
+            Base::line_buffer_.u16[x] = to_rgb332(gl_Color.x, gl_Color.y, gl_Color.z);
         }
     }
 
     void sort_triangle(Triangle &t)
     {
-        std::sort(std::begin(t.v), std::end(t.v), [](const auto &a, const auto &b) {
-            return (a.y < b.y) || (a.y == b.y && a.x < b.x);
+        // vertices and depths are swapped together
+        const auto order = [&t](int a, int b) {
+            if ((t.v[b].y < t.v[a].y) || (t.v[b].y == t.v[a].y && t.v[b].x < t.v[a].x))
+            {
+                std::swap(t.v[a], t.v[b]);
+                std::swap(t.z[a], t.z[b]);
+            }
+        };
+        order(0, 1);
+        order(1, 2);
+        order(0, 1);
+    }
+
+    /// @brief Calculates depth plane of triangle in screen coordinates
+    static depth_plane prepare_depth(const Triangle &t)
+    {
+        depth_plane p{
+            .z_origin = 0.0f,
+            .dzdx     = 0.0f,
+            .dzdy     = 0.0f,
+        };
+
+        const int dx1  = t.v[1].x - t.v[0].x;
+        const int dy1  = t.v[1].y - t.v[0].y;
+        const int dx2  = t.v[2].x - t.v[0].x;
+        const int dy2  = t.v[2].y - t.v[0].y;
+        const int area = dx1 * dy2 - dx2 * dy1;
+        if (area != 0)
+        {
+            const float dz1 = t.z[1] - t.z[0];
+            const float dz2 = t.z[2] - t.z[0];
+            p.dzdx          = (dz1 * static_cast<float>(dy2) - dz2 * static_cast<float>(dy1)) /
+                     static_cast<float>(area);
+            p.dzdy = (static_cast<float>(dx1) * dz2 - static_cast<float>(dx2) * dz1) /
+                     static_cast<float>(area);
+        }
+        p.z_origin = t.z[0] - p.dzdx * t.v[0].x - p.dzdy * t.v[0].y;
+        return p;
+    }
+
+    void render_line(uint16_t line)
+    {
+        std::memset(Base::line_buffer_.u8, Base::render_clear_color(), sizeof(Base::line_buffer_));
+        Base::clear_depth_buffer();
+
+        auto &triangles = triangles_[Base::render_list_];
+        edge_table_[Base::render_list_].process_line(line, [&triangles, this, line](auto id) {
+            PreparedTriangle &triangle = triangles[id];
+            draw_triangle_line(line, triangle);
+            return line < triangle.max_y;
         });
+        Base::write_line(line);
+    }
+
+    /// @brief Moves edges of active triangles to next line without drawing
+    void skip_line(uint16_t line)
+    {
+        auto &triangles = triangles_[Base::render_list_];
+        edge_table_[Base::render_list_].process_line(line, [&triangles, this, line](auto id) {
+            PreparedTriangle &triangle = triangles[id];
+            step_triangle_edges(line, triangle);
+            return line < triangle.max_y;
+        });
+    }
+
+    static uint32_t triangle_signature(const Triangle &t)
+    {
+        uint32_t signature = Base::mix_signature(Base::signature_basis, t.color);
+        for (int i = 0; i < 3; ++i)
+        {
+            signature = Base::mix_signature(signature, static_cast<uint32_t>(t.v[i].x) << 16 |
+                                                           t.v[i].y);
+            if (t.depth_test)
+            {
+                uint32_t z = 0;
+                std::memcpy(&z, &t.z[i], sizeof(z));
+                signature = Base::mix_signature(signature, z);
+            }
+        }
+        return Base::mix_signature(signature, t.depth_test);
+    }
+
+    void step_triangle_edges(uint16_t line, PreparedTriangle &triangle)
+    {
+        if (line < triangle.min_y || line > triangle.max_y)
+        {
+            return;
+        }
+
+        triangle.sx += triangle.dx2;
+        triangle.ex += line < triangle.mid_y ? triangle.dx1 : triangle.dx3;
     }
 
-    void draw_triangle_line(uint16_t line, prepared_triangle &triangle)
+    void draw_triangle_line(uint16_t line, PreparedTriangle &triangle)
     {
         if (line < triangle.min_y || line > triangle.max_y)
         {
             return;
         }
 
-        const float e_dx = line < triangle.mid_y ? triangle.dx1 : triangle.dx3;
-        const float x0   = std::min(triangle.sx, triangle.ex);
-        const float x1   = std::max(triangle.sx, triangle.ex);
-        draw_horizontal_line(static_cast<uint16_t>(round(x0)), static_cast<uint16_t>(round(x1)),
-                             0xf0);
+        const EdgeType e_dx = line < triangle.mid_y ? triangle.dx1 : triangle.dx3;
+        const EdgeType x0   = std::min(triangle.sx, triangle.ex);
+        const EdgeType x1   = std::max(triangle.sx, triangle.ex);
+        if (triangle.depth_plane != PreparedTriangle::no_depth_plane)
+        {
+            draw_depth_tested_line(line, Edge::to_pixel(x0), Edge::to_pixel(x1),
+                                   depth_planes_[Base::render_list_][triangle.depth_plane]);
+        }
+        else
+        {
+            draw_horizontal_line(line, Edge::to_pixel(x0), Edge::to_pixel(x1), flat_color_);
+        }
         triangle.sx += triangle.dx2;
         triangle.ex += e_dx;
     }
 
-    void draw_triangle_lines(int line, prepared_triangle &t)
+    void draw_triangle_lines(int line, PreparedTriangle &t)
     {
         if (line < t.min_y || line > t.max_y)
         {
             return;
         }
 
-        float s_dx = t.dx2;
-        float e_dx = line < t.mid_y ? t.dx1 : t.dx3;
+        constexpr EdgeType one = Edge::from_int(1);
+
+        EdgeType s_dx = t.dx2;
+        EdgeType e_dx = line < t.mid_y ? t.dx1 : t.dx3;
 
-        float prev_sx = t.sx;
-        float prev_ex = t.ex;
+        EdgeType prev_sx = t.sx;
+        EdgeType prev_ex = t.ex;
 
-        if (line != t.max_y && s_dx > 1)
+        if (line != t.max_y && s_dx > one)
         {
-            prev_sx += s_dx - 1.0f;
+            prev_sx += s_dx - one;
         }
 
-        if (line != t.max_y && e_dx > 1)
+        if (line != t.max_y && e_dx > one)
         {
-            prev_ex += e_dx - 1.0f;
+            prev_ex += e_dx - one;
         }
 
-        if (line != t.max_y && s_dx < -1)
+        if (line != t.max_y && s_dx < -one)
         {
-            prev_sx += s_dx + 1.0f;
+            prev_sx += s_dx + one;
         }
 
-        if (line != t.max_y && e_dx < -1)
+        if (line != t.max_y && e_dx < -one)
         {
-            prev_ex += e_dx + 1.0f;
+            prev_ex += e_dx + one;
         }
 
         if ((t.mid_y == t.max_y || t.mid_y == t.min_y) && t.mid_y == line)
         {
-            draw_horizontal_line(static_cast<uint16_t>(round(t.sx)),
-                                 static_cast<uint16_t>(round(t.ex)), t.color);
+            draw_horizontal_line(static_cast<uint16_t>(line), Edge::to_pixel(t.sx),
+                                 Edge::to_pixel(t.ex), flat_color_);
         }
 
-        draw_horizontal_line(static_cast<uint16_t>(round(t.sx)),
-                             static_cast<uint16_t>(round(prev_sx)), t.color);
-        draw_horizontal_line(static_cast<uint16_t>(round(t.ex)),
-                             static_cast<uint16_t>(round(prev_ex)), t.color);
+        draw_horizontal_line(static_cast<uint16_t>(line), Edge::to_pixel(t.sx),
+                             Edge::to_pixel(prev_sx), flat_color_);
+        draw_horizontal_line(static_cast<uint16_t>(line), Edge::to_pixel(t.ex),
+                             Edge::to_pixel(prev_ex), flat_color_);
 
         t.sx += s_dx;
         t.ex += e_dx;
     }
 
-    eul::container::static_deque<prepared_triangle, 4096> triangles_;
+    void write_program_data(std::span<const uint8_t> data)
+    {
+        if (program_write_index_ + data.size() > program_data_.size())
+        {
+            log::Log::error("Program data exceeds declared size: %d", program_data_.size());
+            return;
+        }
+
+        std::copy(data.begin(), data.end(), program_data_.begin() + program_write_index_);
+        program_write_index_ += data.size();
+
+        if (program_write_index_ == program_data_.size())
+        {
+            log::Log::trace("Received program: %d", program_position_);
+            static msos::dl::Environment env{
+                msos::dl::SymbolAddress{SymbolCode::libc_printf, &printf},
+#if MSGPU_SHADER_SPAN
+                msos::dl::SymbolAddress{SymbolCode::shader_gl_Span, &gl_Span},
+#endif
+#if MSGPU_SHADER_VERTEX_BATCH
+                msos::dl::SymbolAddress{SymbolCode::shader_gl_VertexBatch, &gl_VertexBatch},
+#endif
+            };
+
+            static msos::dl::DynamicLinker linker;
+            eul::error::error_code ec;
+
+            const auto *module = linker.load_module(
+                std::span<const uint8_t>(program_data_.data(), program_data_.size()),
+                msos::dl::LoadingModeCopyText, env, ec);
+
+            wait_for_shaders();
+            programs_.add_shader(program_position_, module);
+        }
+    }
+
+    // triangles of one display list, both lists together use the same memory as single list did
+    constexpr static std::size_t max_triangles = 2048;
+    // depth planes are kept aside, so triangles drawn without depth test don't pay for them
+    constexpr static std::size_t max_depth_tested_triangles = max_triangles / 2;
+    using EdgeTable = ActiveEdgeTable<Configuration::resolution_height, max_triangles>;
+
+    eul::container::static_vector<PreparedTriangle, max_triangles> triangles_[Base::display_lists];
+    eul::container::static_vector<depth_plane, max_depth_tested_triangles>
+        depth_planes_[Base::display_lists];
+    EdgeTable edge_table_[Base::display_lists];
 
     Programs programs_;
     std::vector<uint8_t> program_data_; // for now, later this can be written to static buffer
@@ -366,6 +732,12 @@ class GraphicMode2D : public ModeBase<Configuration, I2CType>
         FragmentShader,
     };
     const Program *used_program_;
+    // program of each display list, rendered frame uses own copy, so UseProgram can't change it
+    const Program *list_programs_[Base::display_lists];
+    const Program *last_frame_program_;
+    const Program *render_program_;
+    // colour of primitives drawn without per-pixel shading in rendered frame
+    uint16_t flat_color_;
 };
 
 } // namespace msgpu::mode
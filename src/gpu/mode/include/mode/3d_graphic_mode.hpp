@@ -21,16 +21,20 @@
 #include <cmath>
 #include <cstdio>
 #include <iostream>
+#include <span>
 
 #include <eul/container/static_vector.hpp>
 #include <eul/math/vector.hpp>
 
 #include "mode/2d_graphic_mode.hpp"
+#include "mode/clipping.hpp"
 #include "mode/indexed_buffer.hpp"
 #include "mode/mode_base.hpp"
 #include "mode/programs.hpp"
 #include "mode/types.hpp"
 #include "mode/vertex_attribute.hpp"
+#include "mode/vertex_batch.hpp"
+#include "mode/vertex_cache.hpp"
 
 #include "messages/ack.hpp"
 #include "messages/allocate_program.hpp"
@@ -38,6 +42,7 @@
 #include "messages/begin_primitives.hpp"
 #include "messages/begin_program_write.hpp"
 #include "messages/bind.hpp"
+#include "messages/buffer_target_type.hpp"
 #include "messages/draw_arrays.hpp"
 #include "messages/end_primitives.hpp"
 #include "messages/generate_names.hpp"
@@ -47,7 +52,35 @@
 #include "messages/write_buffer_data.hpp"
 #include "messages/write_vertex.hpp"
 
+// DrawElements is defined in messages/draw_elements.th, it is handled once msgpu_interface
+// generates it
+#if __has_include("messages/draw_elements.hpp")
+#include "messages/draw_elements.hpp"
+#define MSGPU_DRAW_ELEMENTS_MESSAGE 1
+#else
+#define MSGPU_DRAW_ELEMENTS_MESSAGE 0
+#endif
+
+// DeleteNamesRequest is defined in messages/delete_names.th, it is handled once msgpu_interface
+// generates it
+#if __has_include("messages/delete_names.hpp")
+#include "messages/delete_names.hpp"
+#define MSGPU_DELETE_NAMES_MESSAGE 1
+#else
+#define MSGPU_DELETE_NAMES_MESSAGE 0
+#endif
+
+// SetFaceCulling is defined in messages/set_face_culling.th, it is handled once msgpu_interface
+// generates it
+#if __has_include("messages/set_face_culling.hpp")
+#include "messages/set_face_culling.hpp"
+#define MSGPU_FACE_CULLING_MESSAGE 1
+#else
+#define MSGPU_FACE_CULLING_MESSAGE 0
+#endif
+
 #include "buffers/gpu_buffers.hpp"
+#include "buffers/memory_cache.hpp"
 #include "buffers/vertex_array_buffer.hpp"
 
 #include "glm/glm.hpp"
@@ -83,8 +116,11 @@ using Mesh      = eul::container::static_vector<BTriangle, 2048>;
 
 struct DrawRequest
 {
-    uint16_t id;
-    uint16_t size;
+    uint16_t id;   // first vertex, not used for indexed draws
+    uint16_t size; // number of vertices
+    uint8_t index_size;
+    uint16_t element_buffer;
+    uint32_t offset; // offset of first index in element buffer
 };
 using DrawRequests = eul::container::static_vector<DrawRequest, 2048>;
 
@@ -97,13 +133,39 @@ class GraphicMode3D : public GraphicMode2D<Configuration, I2CType>
     using Base::process;
     using Base::template ModeBase<Configuration, I2CType>::process;
 
+    constexpr static std::size_t vertex_batch_size  = 48;
+    constexpr static std::size_t vertex_cache_size  = 128;
+    constexpr static std::size_t indices_chunk_size = 64;
+
     GraphicMode3D(memory::VideoRam &framebuffer, memory::GpuRAM &gpuram, I2CType &i2c,
-                  io::UsartPoint &point)
-        : Base::GraphicMode2D(framebuffer, gpuram, i2c, point)
-        , gpu_buffers_(Base::gpuram_)
-        , vertex_array_buffer_(Base::gpuram_)
+                  io::UsartPoint &point, RenderCore *render_core = nullptr)
+        : Base::GraphicMode2D(framebuffer, gpuram, i2c, point, render_core)
+        , current_buffer_(no_buffer)
+        , current_element_buffer_(no_buffer)
+        , current_array_buffer_(no_array)
+        , memory_cache_(Base::gpuram_)
+        , gpu_buffers_(memory_cache_)
+        , vertex_array_buffer_(memory_cache_)
+        , default_array_{}
+        , vertex_attributes_(default_array_.attributes)
+        , clipper_(Configuration::resolution_width, Configuration::resolution_height)
+        , face_culling_(FaceCulling::None)
+    {
+        // until perspective is set, vertex shader output is used as clip coordinates
+        projection_ = {
+            {1, 0, 0, 0},
+            {0, 1, 0, 0},
+            {0, 0, 1, 0},
+            {0, 0, 0, 1},
+        };
+        // vertex arrays are stored in the same memory as buffers
+        gpu_buffers_.reserve_memory(vertex_array_buffer_.start_address,
+                                    vertex_array_buffer_.memory_size);
+    }
+
+    ~GraphicMode3D() override
     {
-        set_projection_matrix(90.0f, 1.0f, 1000.0f, 1.0f);
+        this->wait_for_render();
     }
 
     void clear() override
@@ -133,9 +195,15 @@ class GraphicMode3D : public GraphicMode2D<Configuration, I2CType>
         if (req.type == BindObjectType::BindVertexArray)
         {
             current_array_buffer_ = req.object_id - 1;
+            bind_vertex_array();
         }
         if (req.type == BindObjectType::BindBuffer)
         {
+            if (req.target == BufferTargetType::ElementArrayBuffer)
+            {
+                current_element_buffer_ = req.object_id - 1;
+                return;
+            }
             current_buffer_ = req.object_id - 1;
         }
     }
@@ -150,7 +218,14 @@ class GraphicMode3D : public GraphicMode2D<Configuration, I2CType>
             return;
         }
 
-        auto &attrib      = vertex_attributes_[msg.index];
+        // state of bound array is resident, so it is modified in place
+        VertexArrayState *state = vertex_array_buffer_.modify(current_array_buffer_);
+        if (state == nullptr)
+        {
+            state = &default_array_;
+        }
+
+        auto &attrib      = state->attributes[msg.index];
         attrib.normalized = msg.normalized;
         attrib.size       = msg.size & 0x3;
         attrib.stride     = msg.stride;
@@ -180,7 +255,7 @@ class GraphicMode3D : public GraphicMode2D<Configuration, I2CType>
 
     void process(const PrepareForData &req)
     {
-        write_buffer_ = req.named ? req.object_id - 1 : current_buffer_;
+        write_buffer_ = req.named ? req.object_id - 1 : bound_buffer(req.target);
         log::Log::trace("Received write buffer preparation for: %d, size: %d", write_buffer_,
                         req.size);
 
@@ -197,16 +272,26 @@ class GraphicMode3D : public GraphicMode2D<Configuration, I2CType>
         write_offset_ += msg.size;
     }
 
+    void process(const io::BufferDataBlock &block)
+    {
+        log::Log::trace("Received data block with size %d", block.data.size());
+
+        gpu_buffers_.write(write_buffer_, block.data.data(), block.data.size(), write_offset_);
+
+        write_offset_ += block.data.size();
+    }
+
+    /// @brief Sets projection applied to vertex shader output, w of projected vertex is depth
     void set_projection_matrix(float view_angle, float aspect, float z_far, float z_near)
     {
         const float theta = view_angle * 0.5f;
         const float F     = 1.0f / (tanf(theta / 180.0f * 3.14f));
-        const float a     = -1.0f * aspect;
+        const float a     = aspect;
         const float q     = z_far / (z_far - z_near);
 
         projection_ = {
             {a * F, 0, 0, 0},
-            {0, -F, 0, 0},
+            {0, F, 0, 0},
             {0, 0, q, 1},
             {0, 0, -1 * z_near * q, 0},
         };
@@ -240,17 +325,90 @@ class GraphicMode3D : public GraphicMode2D<Configuration, I2CType>
             resp.data[i] = ids[i] + 1;
         }
 
-        this->point_.write(resp);
+        this->respond(resp);
+    }
+
+#if MSGPU_DELETE_NAMES_MESSAGE
+    void process(const DeleteNamesRequest &msg)
+    {
+        log::Log::trace("Received DeleteNamesRequest for %d elements. Type %d", msg.elements,
+                        msg.type);
+        const std::size_t elements = std::min<std::size_t>(msg.elements, std::size(msg.data));
+        delete_names(static_cast<ObjectType>(msg.type),
+                     std::span<const uint16_t>(msg.data, elements));
+    }
+#endif // MSGPU_DELETE_NAMES_MESSAGE
+
+    /// @brief Releases vertex arrays or buffers, deleted objects which are bound are unbound
+    ///
+    /// @param type - type of released objects
+    /// @param names - names returned by GenerateNamesResponse
+    void delete_names(ObjectType type, std::span<const uint16_t> names)
+    {
+        for (const uint16_t name : names)
+        {
+            uint16_t id = static_cast<uint16_t>(name - 1);
+            if (type == ObjectType::VertexArray)
+            {
+                vertex_array_buffer_.release_names(1, &id);
+                // attributes of bound array pointed to released slot
+                if (id == current_array_buffer_)
+                {
+                    current_array_buffer_ = no_array;
+                    bind_vertex_array();
+                }
+                continue;
+            }
+
+            gpu_buffers_.release_names(1, &id);
+            if (id == current_buffer_)
+            {
+                current_buffer_ = no_buffer;
+            }
+            if (id == current_element_buffer_)
+            {
+                current_element_buffer_ = no_buffer;
+            }
+        }
     }
 
     void process(const DrawArrays &msg)
     {
         log::Log::trace("Draw arrays from %d to %d", msg.first, msg.count);
         requests_.emplace_back(DrawRequest{
-            .id   = msg.first,
-            .size = msg.count,
+            .id             = msg.first,
+            .size           = msg.count,
+            .index_size     = 0,
+            .element_buffer = 0,
+            .offset         = 0,
+        });
+    }
+
+#if MSGPU_DRAW_ELEMENTS_MESSAGE
+    void process(const DrawElements &msg)
+    {
+        log::Log::trace("Draw elements %d from offset %d", msg.count, msg.offset);
+        if (current_element_buffer_ == no_buffer)
+        {
+            log::Log::error("%s", "Draw elements without bound element buffer");
+            return;
+        }
+
+        if (msg.type > DrawElementsType::UnsignedInt)
+        {
+            log::Log::error("Unsupported index type: %d", msg.type);
+            return;
+        }
+
+        requests_.emplace_back(DrawRequest{
+            .id             = 0,
+            .size           = msg.count,
+            .index_size     = static_cast<uint8_t>(1 << msg.type),
+            .element_buffer = current_element_buffer_,
+            .offset         = msg.offset,
         });
     }
+#endif // MSGPU_DRAW_ELEMENTS_MESSAGE
 
     void process(const GetNamedParameterIdReq &msg)
     {
@@ -259,16 +417,32 @@ class GraphicMode3D : public GraphicMode2D<Configuration, I2CType>
         {
             const uint8_t id = prog->get_named_parameter_id(msg.name);
             GetNamedParameterIdResp resp{.parameter_id = id};
-            this->point_.write(resp);
+            this->respond(resp);
         }
     }
 
-    void render() override
+    /// @brief Selects winding of triangles dropped during primitive assembly
+    void set_face_culling(FaceCulling culling)
     {
-        this->framebuffer_.block();
-        transform_mesh();
-        Base::render();
-        this->framebuffer_.unblock();
+        face_culling_ = culling;
+    }
+
+#if MSGPU_FACE_CULLING_MESSAGE
+    void process(const SetFaceCulling &msg)
+    {
+        if (msg.mode > static_cast<uint8_t>(FaceCulling::CounterClockwise))
+        {
+            log::Log::error("Unknown face culling mode: %d", msg.mode);
+            return;
+        }
+        set_face_culling(static_cast<FaceCulling>(msg.mode));
+    }
+#endif // MSGPU_FACE_CULLING_MESSAGE
+
+    /// @brief Post-transform vertex cache, exposes hit/miss statistics of last prepared frame
+    const VertexCache<vertex_cache_size> &vertex_cache() const
+    {
+        return vertex_cache_;
     }
 
     void process(const PrepareForParameterData &msg)
@@ -288,148 +462,287 @@ class GraphicMode3D : public GraphicMode2D<Configuration, I2CType>
     }
 
   protected:
+    /// @brief Transforms vertices of draw requests to triangles of build display list
+    void prepare_frame() override
+    {
+        // vertex shader arguments are shared with pixel shader of rendered frame
+        Base::wait_for_shaders();
+        this->framebuffer_.block();
+        transform_mesh();
+        this->framebuffer_.unblock();
+        Base::prepare_frame();
+    }
+
     void transform_mesh()
     {
-        FloatVertex v[3];
+        const uint16_t buffer = vertices_buffer();
+        // transformed vertices and statistics are valid for single frame
+        vertex_cache_.clear();
+        vertex_cache_.reset_statistics();
         for (const auto &request : requests_)
         {
-            int vertex_pos = 0;
-            for (int i = 0; i < request.size; ++i)
+            assembled_vertices_ = 0;
+            uint32_t indices[indices_chunk_size];
+            for (std::size_t i = 0; i < request.size; i += indices_chunk_size)
             {
-                uint8_t buffer[shader_in_arguments_size][sizeof(std::size_t) * 4];
-                for (int j = 0; j < shader_in_arguments_size; ++j)
-                {
-                    if (vertex_attributes_[j].used)
-                    {
-                        const std::size_t size        = vertex_attributes_[j].size * sizeof(float);
-                        const std::size_t offset_size = vertex_attributes_[j].stride == 0
-                                                            ? vertex_attributes_[j].size
-                                                            : vertex_attributes_[j].stride;
-                        const std::size_t offset = offset_size * i + vertex_attributes_[j].offset;
-                        gpu_buffers_.read(vertex_attributes_[j].buffer, buffer[j], size, offset);
-                        in_argument_pointer[j] = buffer[j];
-                    }
-                }
+                const std::size_t count = std::min(indices_chunk_size, request.size - i);
+                read_indices(request, i, count, indices);
+                process_vertices(buffer, indices, count);
+            }
+        }
+        log::Log::trace("Vertex cache hits: %d, misses: %d",
+                        static_cast<int>(vertex_cache_.hits()),
+                        static_cast<int>(vertex_cache_.misses()));
+    }
 
-                vec3 color;
-                out_argument_pointer[0] = &color;
-                if (this->used_program_ && this->used_program_->vertex_shader())
-                {
-                    this->used_program_->vertex_shader()->execute();
-                }
+    /// @brief Executes vertex shader for loaded batch
+    ///
+    /// @details
+    ///   Whole batch is passed with single call when shader exports shade_vertices,
+    ///   otherwise main is executed for each vertex.
+    void run_vertex_shader()
+    {
+        const msos::dl::LoadedModule *shader = nullptr;
+        if (this->used_program_)
+        {
+            shader = this->used_program_->vertex_shader();
+        }
 
-                v[vertex_pos] = FloatVertex{
-                    .x = gl_Position.x,
-                    .y = gl_Position.y,
-                    .z = gl_Position.z,
-                };
-                if (++vertex_pos == 3)
-                {
-                    vertex_pos      = 0;
-                    FloatTriangle t = {
-                        .color = Base::to_rgb332(color.x, color.y, color.z),
-                        .vertex =
-                            {
-                                v[0],
-                                v[1],
-                                v[2],
-                            },
-                    };
-
-                    calculate_projection(t);
-                    scale(t);
-                    Triangle tg = {.color = t.color,
-                                   .v     = {
-                                       vertex_2d{
-                                           .x = static_cast<uint16_t>(t.vertex[0].x),
-                                           .y = static_cast<uint16_t>(t.vertex[0].y),
-                                       },
-                                       vertex_2d{
-                                           .x = static_cast<uint16_t>(t.vertex[1].x),
-                                           .y = static_cast<uint16_t>(t.vertex[1].y),
-                                       },
-                                       vertex_2d{
-                                           .x = static_cast<uint16_t>(t.vertex[2].x),
-                                           .y = static_cast<uint16_t>(t.vertex[2].y),
-                                       },
-                                   }};
-                    Base::add_triangle(tg);
-                }
+#if MSGPU_SHADER_VERTEX_BATCH
+        if (shader && this->used_program_->vertex_batch_shader())
+        {
+            ShaderVertexBatch batch = vertex_batch_.descriptor();
+            gl_VertexBatch          = &batch;
+            this->used_program_->vertex_batch_shader()();
+            gl_VertexBatch = nullptr;
+            return;
+        }
+#endif
+
+        for (std::size_t vertex = 0; vertex < vertex_batch_.size(); ++vertex)
+        {
+            vertex_batch_.set_arguments(vertex, in_argument_pointer);
+            out_argument_pointer[0] = &vertex_batch_.colors[vertex];
+            if (shader)
+            {
+                shader->execute();
+            }
+            vertex_batch_.positions[vertex] = gl_Position;
+        }
+    }
+
+    /// @brief Reads indices of vertices from draw request
+    ///
+    /// @details
+    ///   For indexed draws indices are bulk-read from element buffer,
+    ///   otherwise consecutive indices are generated.
+    void read_indices(const DrawRequest &request, std::size_t first, std::size_t count,
+                      uint32_t *indices)
+    {
+        if (request.index_size == 0)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                indices[i] = static_cast<uint32_t>(request.id + first + i);
+            }
+            return;
+        }
+
+        uint8_t data[indices_chunk_size * sizeof(uint32_t)];
+        gpu_buffers_.read(request.element_buffer, data, count * request.index_size,
+                          request.offset + first * request.index_size);
+
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            switch (request.index_size)
+            {
+            case sizeof(uint8_t): {
+                indices[i] = data[i];
+            }
+            break;
+            case sizeof(uint16_t): {
+                uint16_t index;
+                std::memcpy(&index, &data[i * sizeof(uint16_t)], sizeof(uint16_t));
+                indices[i] = index;
+            }
+            break;
+            default: {
+                std::memcpy(&indices[i], &data[i * sizeof(uint32_t)], sizeof(uint32_t));
+            }
+            }
+        }
+    }
+
+    /// @brief Sends vertices to rasterizer, transforming only not cached ones
+    ///
+    /// @details
+    ///   Not cached vertices with consecutive indices are transformed in single batch.
+    void process_vertices(uint16_t buffer, const uint32_t *indices, std::size_t count)
+    {
+        std::size_t i = 0;
+        while (i < count)
+        {
+            if (const TransformedVertex *cached = vertex_cache_.find(buffer, indices[i]))
+            {
+                assemble_triangle(*cached);
+                ++i;
+                continue;
+            }
+
+            std::size_t batch = 1;
+            while (batch < vertex_batch_size && i + batch < count &&
+                   indices[i + batch] == indices[i] + batch &&
+                   !vertex_cache_.contains(buffer, indices[i + batch]))
+            {
+                ++batch;
+            }
+            transform_vertices(buffer, indices[i], batch);
+            i += batch;
+        }
+    }
+
+    /// @brief Points vertex attributes to state of bound array, without array default is used
+    void bind_vertex_array()
+    {
+        const VertexArrayState *state = vertex_array_buffer_.bind(current_array_buffer_);
+        if (state == nullptr)
+        {
+            if (current_array_buffer_ != no_array)
+            {
+                log::Log::error("Vertex array %d doesn't exist", current_array_buffer_ + 1);
+            }
+            state = &default_array_;
+        }
+        vertex_attributes_ = state->attributes;
+    }
+
+    uint16_t bound_buffer(BufferTargetType target) const
+    {
+        return target == BufferTargetType::ElementArrayBuffer ? current_element_buffer_
+                                                               : current_buffer_;
+    }
+
+    /// @brief Transforms vertices with vertex shader and stores them in vertex cache
+    void transform_vertices(uint16_t buffer, uint32_t first, std::size_t count)
+    {
+        vertex_batch_.load(gpu_buffers_, vertex_attributes_, first, count);
+        run_vertex_shader();
+
+        for (std::size_t i = 0; i < vertex_batch_.size(); ++i)
+        {
+            const TransformedVertex vertex =
+                transform(vertex_batch_.positions[i], vertex_batch_.colors[i]);
+            vertex_cache_.insert(buffer, static_cast<uint32_t>(first + i), vertex);
+            assemble_triangle(vertex);
+        }
+    }
+
+    /// @brief Projects vertex shader output, perspective divide is done after near plane clipping
+    TransformedVertex transform(const vec4 &position, const vec3 &color)
+    {
+        const float in[4] = {position.x, position.y, position.z, position.w};
+        float out[4]      = {};
+        for (std::size_t column = 0; column < 4; ++column)
+        {
+            for (std::size_t row = 0; row < 4; ++row)
+            {
+                out[column] += in[row] * projection_[row][column];
+            }
+        }
+
+        return TransformedVertex{
+            .position =
+                clip_vertex{
+                    .x = out[0],
+                    .y = out[1],
+                    .z = out[2],
+                    .w = out[3],
+                },
+            .color = Base::to_rgb332(color.x, color.y, color.z),
+        };
+    }
+
+    /// @brief Buffer used as vertex cache key, buffer of first used attribute
+    uint16_t vertices_buffer() const
+    {
+        for (std::size_t i = 0; i < shader_in_arguments_size; ++i)
+        {
+            if (vertex_attributes_[i].used)
+            {
+                return vertex_attributes_[i].buffer;
             }
-            //
-            // printf("Send arguments: {%f %f %f}\n", v[0], v[1], v[2]);
-            // uint8_t buffer[4 * sizeof(std::size_t) * shader_in_arguments_size] = {};
-            // set_arguments(buffer);
-            // if (this->used_program_ && this->used_program_->vertex_shader())
-            // {
-            // this->used_program_->vertex_shader_->execute();
-            // }
-            // printf("Position {%f %f %f}\n", gl_Position.x, gl_Position.y, gl_Position.z);
-            // Vertex v1 = {.x = gl_Position.x, .y = gl_Position.y, .z = gl_Position.z};
-            // set_arguments(buffer);
-            // if (this->used_program_ && this->used_program_->vertex_shader())
-            // {
-            // this->used_program_->vertex_shader_->execute();
-            // }
-            // Vertex v2 = {.x = gl_Position.x, .y = gl_Position.y, .z = gl_Position.z};
-            //
-            // set_arguments(buffer);
-            // if (this->used_program_ && this->used_program_->vertex_shader())
-            // {
-            // this->used_program_->vertex_shader_->execute();
-            // }
-            // Vertex v3 = {.x = gl_Position.x, .y = gl_Position.y, .z = gl_Position.z};
-            //
-            // BTriangle triangle{v1, v2, v3};
-            //
-            // FloatTriangle t = convert(triangle);
-            //
-            // FloatVertex normal, line1, line2;
-            // line1.x = t.vertex[1].x - t.vertex[0].x;
-            // line1.y = t.vertex[1].y - t.vertex[0].y;
-            // line1.z = t.vertex[1].z - t.vertex[0].z;
-            //
-            // line2.x = t.vertex[2].x - t.vertex[1].x;
-            // line2.y = t.vertex[2].y - t.vertex[1].y;
-            // line2.z = t.vertex[2].z - t.vertex[1].z;
-            //
-            // normal.x = line1.y * line2.z - line1.z * line2.y;
-            // normal.y = line1.z * line2.x - line1.x * line2.z;
-            // normal.z = line1.x * line2.y - line1.y * line2.x;
-            //
-            // float l = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
-            // normal.x /= l;
-            // normal.y /= l;
-            // normal.z /= l;
-            //
-            // if (normal.x * (t.vertex[0].x - camera_.x) + normal.y * (t.vertex[0].y - camera_.y) +
-            // normal.z * (t.vertex[0].z - camera_.z) >=
-            // 0.0)
-            // {
-            // continue;
-            // }
-            //
-            // FloatVertex light{.x = 0, .y = 0, .z = -1};
-            // l = sqrtf(light.x * light.x + light.y * light.y + light.z * light.z);
-            // light.x /= l;
-            // light.y /= l;
-            // light.z /= l;
-            //
-            // calculate_projection(t);
-            //
-            // scale(t);
-            //
-            // Triangle tr{.v = {vertex_2d{.x = static_cast<uint16_t>(t.vertex[0].x),
-            // .y = static_cast<uint16_t>(t.vertex[0].y)},
-            //   vertex_2d{.x = static_cast<uint16_t>(t.vertex[1].x),
-            // .y = static_cast<uint16_t>(t.vertex[1].y)},
-            //   vertex_2d{.x = static_cast<uint16_t>(t.vertex[2].x),
-            // .y = static_cast<uint16_t>(t.vertex[2].y)}}};
-            //
-            // Base::add_triangle(tr, 0);
+        }
+        return 0;
+    }
+
+    /// @brief Collects transformed vertices into triangles and sends them to rasterizer
+    void assemble_triangle(const TransformedVertex &vertex)
+    {
+        assembled_[assembled_vertices_] = vertex;
+
+        if (++assembled_vertices_ < 3)
+        {
+            return;
+        }
+
+        assembled_vertices_ = 0;
+        const clip_vertex triangle[3] = {
+            assembled_[0].position,
+            assembled_[1].position,
+            assembled_[2].position,
+        };
+
+        clip_vertex clipped[4];
+        const std::size_t size = clip_near_plane(triangle, clipped, near_plane_w);
+
+        screen_vertex projected[4];
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            projected[i] = clipper_.project(clipped[i]);
+        }
+
+        // polygon clipped by near plane is convex, so it can be split into triangles fan
+        for (std::size_t i = 1; i + 1 < size; ++i)
+        {
+            rasterize_triangle({projected[0], projected[i], projected[i + 1]}, assembled_[2].color);
         }
     }
 
+    /// @brief Culls projected triangle, clips it to viewport and sends it to rasterizer
+    void rasterize_triangle(const screen_vertex (&triangle)[3], uint16_t color)
+    {
+        if (is_culled(face_culling_, triangle[0], triangle[1], triangle[2]))
+        {
+            return;
+        }
+
+        ViewportClipper::Polygon polygon;
+        const std::size_t size = clipper_.clip(triangle, polygon);
+
+        // clipped polygon is convex, so it can be split into triangles fan
+        for (std::size_t i = 1; i + 1 < size; ++i)
+        {
+            Base::add_triangle(Triangle{
+                .color      = color,
+                .v          = {
+                    to_screen(polygon[0]),
+                    to_screen(polygon[i]),
+                    to_screen(polygon[i + 1]),
+                },
+                .z          = {polygon[0].z, polygon[i].z, polygon[i + 1].z},
+                .depth_test = true,
+            });
+        }
+    }
+
+    static vertex_2d to_screen(const screen_vertex &v)
+    {
+        return vertex_2d{
+            .x = static_cast<uint16_t>(v.x),
+            .y = static_cast<uint16_t>(v.y),
+        };
+    }
+
     void set_arguments(uint8_t *buffer)
     {
         for (int i = 0; i < shader_in_arguments_size; ++i)
@@ -443,16 +756,21 @@ class GraphicMode3D : public GraphicMode2D<Configuration, I2CType>
     {
         for (auto &v : t.vertex)
         {
-            v.x     = projection_[0][0] * v.x;
-            v.y     = projection_[1][1] * v.y;
-            v.z     = projection_[2][2] * v.z;
-            float w = projection_[3][2] * v.z;
+            calculate_projection(v);
+        }
+    }
 
-            if (w > 0.000001f || w < -0.000001f)
-            {
-                v.x /= w;
-                v.y /= w;
-            }
+    void calculate_projection(FloatVertex &v)
+    {
+        v.x     = projection_[0][0] * v.x;
+        v.y     = projection_[1][1] * v.y;
+        v.z     = projection_[2][2] * v.z;
+        float w = projection_[3][2] * v.z;
+
+        if (w > 0.000001f || w < -0.000001f)
+        {
+            v.x /= w;
+            v.y /= w;
         }
     }
 
@@ -460,14 +778,19 @@ class GraphicMode3D : public GraphicMode2D<Configuration, I2CType>
     {
         for (auto &v : t.vertex)
         {
-            v.x += 1.0f;
-            v.y += 1.0f;
-
-            v.x *= 0.5f * (Configuration::resolution_width - 1);
-            v.y *= 0.5f * (Configuration::resolution_height - 1);
+            scale(v);
         }
     }
 
+    void scale(FloatVertex &v)
+    {
+        v.x += 1.0f;
+        v.y += 1.0f;
+
+        v.x *= 0.5f * (Configuration::resolution_width - 1);
+        v.y *= 0.5f * (Configuration::resolution_height - 1);
+    }
+
     void rotate_x(FloatTriangle &t, float theta)
     {
         const float c_theta = cosf(theta);
@@ -522,7 +845,15 @@ class GraphicMode3D : public GraphicMode2D<Configuration, I2CType>
 
     using Matrix_4x4 = eul::math::matrix<float, 4, 4>;
 
+    // vertices closer to eye are clipped, so perspective divide is always defined
+    constexpr static float near_plane_w = 1.0f / 1024;
+
+    // name 0 unbinds vertex array or buffer
+    constexpr static uint16_t no_array  = 0xffff;
+    constexpr static uint16_t no_buffer = 0xffff;
+
     uint16_t current_buffer_;
+    uint16_t current_element_buffer_;
     uint16_t current_array_buffer_;
     uint16_t write_buffer_;
     std::size_t write_offset_;
@@ -532,9 +863,21 @@ class GraphicMode3D : public GraphicMode2D<Configuration, I2CType>
 
     Mesh mesh_;
     DrawRequests requests_;
-    buffers::GpuBuffers<memory::GpuRAM> gpu_buffers_;
-    buffers::VertexArrayBuffer<memory::GpuRAM, 1024> vertex_array_buffer_;
-    VertexAttribute vertex_attributes_[shader_in_arguments_size];
+    // vertex data and array descriptors are read every frame, GPU RAM is accessed only by cache
+    using MemoryCache = buffers::MemoryCache<memory::GpuRAM>;
+    MemoryCache memory_cache_;
+    buffers::GpuBuffers<MemoryCache> gpu_buffers_;
+    buffers::VertexArrayBuffer<MemoryCache, 1024, VertexArrayState> vertex_array_buffer_;
+    // attributes used when no vertex array is bound
+    VertexArrayState default_array_;
+    // attributes of bound vertex array, resident state or default_array_
+    const VertexAttribute *vertex_attributes_;
+    VertexBatch<vertex_batch_size> vertex_batch_;
+    VertexCache<vertex_cache_size> vertex_cache_;
+    TransformedVertex assembled_[3];
+    std::size_t assembled_vertices_;
+    ViewportClipper clipper_;
+    FaceCulling face_culling_;
     uint8_t parameter_data_[1024];
     uint16_t parameter_id_;
     uint16_t parameter_size_;
@@ -0,0 +1,175 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace msgpu::mode
+{
+
+/// @brief Scanline active edge table for triangles
+///
+/// @details
+///   Triangles are inserted into edge table bucket selected by first line
+///   they cover, so submission may be done in any order.
+///   When scan reaches bucket line, triangles are moved to active list.
+///   Active list is ordered by triangle index, which is submission order,
+///   so overdraw order is preserved. Triangle may be retired from any place
+///   of active list in O(1) during traversal.
+///   Both lists are intrusive, single next link per triangle is enough,
+///   because triangle is never in bucket and active list at the same time.
+///
+/// @tparam lines - number of lines on screen
+/// @tparam capacity - maximal number of triangles
+template <std::size_t lines, std::size_t capacity>
+class ActiveEdgeTable
+{
+  public:
+    using IndexType = uint16_t;
+
+    constexpr static IndexType end_marker = 0xffff;
+
+    static_assert(capacity < end_marker, "Capacity must be addressable with IndexType");
+
+    ActiveEdgeTable()
+    {
+        clear();
+    }
+
+    /// @brief Insert triangle into edge table
+    ///
+    /// @param triangle - index of triangle, must be greater than previously inserted ones
+    /// @param min_y - first line covered by triangle
+    void insert(IndexType triangle, uint16_t min_y)
+    {
+        if (min_y >= lines || triangle >= capacity)
+        {
+            return;
+        }
+
+        next_[triangle] = end_marker;
+        if (tails_[min_y] == end_marker)
+        {
+            heads_[min_y] = triangle;
+        }
+        else
+        {
+            next_[tails_[min_y]] = triangle;
+        }
+        tails_[min_y] = triangle;
+    }
+
+    /// @brief Activate triangles starting at line and visit all active ones
+    ///
+    /// @param line - current line, lines must be processed in increasing order
+    /// @param visitor - called with index of each active triangle,
+    ///                  returns false when triangle should be retired
+    template <typename Visitor>
+    void process_line(uint16_t line, Visitor &&visitor)
+    {
+        if (line < lines)
+        {
+            activate(line);
+        }
+
+        IndexType prev    = end_marker;
+        IndexType current = active_;
+        while (current != end_marker)
+        {
+            const IndexType next = next_[current];
+            if (visitor(current))
+            {
+                prev = current;
+            }
+            else
+            {
+                unlink(prev, next);
+            }
+            current = next;
+        }
+    }
+
+    bool empty() const
+    {
+        return active_ == end_marker;
+    }
+
+    void clear()
+    {
+        heads_.fill(end_marker);
+        tails_.fill(end_marker);
+        active_ = end_marker;
+    }
+
+  private:
+    void unlink(IndexType prev, IndexType next)
+    {
+        if (prev == end_marker)
+        {
+            active_ = next;
+        }
+        else
+        {
+            next_[prev] = next;
+        }
+    }
+
+    /// Merges bucket into active list, both are sorted by triangle index
+    void activate(uint16_t line)
+    {
+        IndexType incoming = heads_[line];
+        if (incoming == end_marker)
+        {
+            return;
+        }
+        heads_[line] = end_marker;
+        tails_[line] = end_marker;
+
+        IndexType prev    = end_marker;
+        IndexType current = active_;
+        while (incoming != end_marker)
+        {
+            while (current != end_marker && current < incoming)
+            {
+                prev    = current;
+                current = next_[current];
+            }
+
+            const IndexType next_incoming = next_[incoming];
+            next_[incoming]               = current;
+            if (prev == end_marker)
+            {
+                active_ = incoming;
+            }
+            else
+            {
+                next_[prev] = incoming;
+            }
+            prev     = incoming;
+            incoming = next_incoming;
+        }
+    }
+
+    std::array<IndexType, lines> heads_;
+    std::array<IndexType, lines> tails_;
+    std::array<IndexType, capacity> next_;
+    IndexType active_;
+};
+
+} // namespace msgpu::mode
@@ -0,0 +1,280 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "mode/vertex.hpp"
+
+namespace msgpu::mode
+{
+
+/// @brief Selects which triangles are culled by winding in screen space
+enum class FaceCulling : uint8_t
+{
+    None,
+    Clockwise,
+    CounterClockwise,
+};
+
+/// @brief Twice the signed area of triangle, positive for counter clockwise winding
+inline float signed_area(const screen_vertex &a, const screen_vertex &b, const screen_vertex &c)
+{
+    return (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+}
+
+/// @returns true if triangle must be dropped, degenerated triangles are always dropped
+inline bool is_culled(FaceCulling culling, const screen_vertex &a, const screen_vertex &b,
+                      const screen_vertex &c)
+{
+    const float area = signed_area(a, b, c);
+    if (!(area > 0.0f || area < 0.0f))
+    {
+        return true;
+    }
+
+    switch (culling)
+    {
+    case FaceCulling::Clockwise:
+        return area < 0.0f;
+    case FaceCulling::CounterClockwise:
+        return area > 0.0f;
+    case FaceCulling::None:
+        break;
+    }
+    return false;
+}
+
+/// @brief Clips triangle against near plane, before perspective divide
+///
+/// @details
+///   Vertices with w below near are behind or too close to the eye, perspective divide
+///   would mirror them or move them to infinity. Every output vertex has w >= near,
+///   so it can always be divided. Clipping one vertex away produces quad, so polygon
+///   has up to 4 vertices with same winding as triangle.
+///
+/// @param triangle - projected triangle
+/// @param polygon - output polygon
+/// @param near - smallest w of visible vertex, must be positive
+///
+/// @returns number of polygon vertices, 0 if triangle is behind near plane
+inline std::size_t clip_near_plane(const clip_vertex (&triangle)[3], clip_vertex (&polygon)[4],
+                                   float near)
+{
+    std::size_t size            = 0;
+    const clip_vertex *previous = &triangle[2];
+    float previous_distance     = previous->w - near;
+    for (const clip_vertex &current : triangle)
+    {
+        const float current_distance = current.w - near;
+        if ((previous_distance >= 0.0f) != (current_distance >= 0.0f))
+        {
+            const float t   = previous_distance / (previous_distance - current_distance);
+            polygon[size++] = clip_vertex{
+                .x = previous->x + (current.x - previous->x) * t,
+                .y = previous->y + (current.y - previous->y) * t,
+                .z = previous->z + (current.z - previous->z) * t,
+                // exactly on plane, rounding errors could move it behind
+                .w = near,
+            };
+        }
+
+        if (current_distance >= 0.0f)
+        {
+            polygon[size++] = current;
+        }
+        previous          = &current;
+        previous_distance = current_distance;
+    }
+    return size >= 3 ? size : 0;
+}
+
+/// @brief Clips triangles against viewport rectangle
+///
+/// @details
+///   Triangles fully outside of one viewport edge are rejected without clipping,
+///   triangles fully inside are passed unchanged. Only triangles crossing viewport
+///   edges are clipped with Sutherland-Hodgman algorithm, depth is interpolated
+///   together with screen position.
+class ViewportClipper
+{
+  public:
+    /// @brief Each edge of viewport may add one vertex to triangle
+    constexpr static std::size_t max_vertices = 7;
+
+    using Polygon = screen_vertex[max_vertices];
+
+    ViewportClipper(float width, float height)
+        : max_x_(width - 1)
+        , max_y_(height - 1)
+    {
+    }
+
+    /// @brief Divides vertex by w and maps it to viewport, y axis points up
+    ///
+    /// @param v - vertex clipped against near plane, w is positive
+    screen_vertex project(const clip_vertex &v) const
+    {
+        const float x = v.x / v.w;
+        const float y = v.y / v.w;
+        return screen_vertex{
+            .x = (x + 1.0f) * 0.5f * max_x_,
+            .y = (1.0f - y) * 0.5f * max_y_,
+            .z = v.z / v.w,
+        };
+    }
+
+    /// @brief Clips triangle to viewport
+    ///
+    /// @param triangle - triangle in screen coordinates
+    /// @param polygon - output polygon, convex and with same winding as triangle
+    ///
+    /// @returns number of polygon vertices, 0 if triangle is outside of viewport
+    std::size_t clip(const screen_vertex (&triangle)[3], Polygon &polygon) const
+    {
+        uint8_t outside_all = 0xff;
+        uint8_t outside_any = 0;
+        for (const auto &v : triangle)
+        {
+            const uint8_t code = outcode(v);
+            outside_all &= code;
+            outside_any |= code;
+        }
+
+        if (outside_all)
+        {
+            return 0;
+        }
+
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            polygon[i] = triangle[i];
+        }
+
+        if (!outside_any)
+        {
+            return 3;
+        }
+
+        Polygon temporary;
+        std::size_t size = clip_edge(polygon, 3, temporary, Left);
+        size             = clip_edge(temporary, size, polygon, Right);
+        size             = clip_edge(polygon, size, temporary, Top);
+        size             = clip_edge(temporary, size, polygon, Bottom);
+        return size >= 3 ? size : 0;
+    }
+
+  private:
+    enum Edge : uint8_t
+    {
+        Left   = 1,
+        Right  = 2,
+        Top    = 4,
+        Bottom = 8,
+    };
+
+    uint8_t outcode(const screen_vertex &v) const
+    {
+        uint8_t code = 0;
+        code |= v.x < 0.0f ? Left : 0;
+        code |= v.x > max_x_ ? Right : 0;
+        code |= v.y < 0.0f ? Top : 0;
+        code |= v.y > max_y_ ? Bottom : 0;
+        return code;
+    }
+
+    float distance(const screen_vertex &v, Edge edge) const
+    {
+        switch (edge)
+        {
+        case Left:
+            return v.x;
+        case Right:
+            return max_x_ - v.x;
+        case Top:
+            return v.y;
+        case Bottom:
+            return max_y_ - v.y;
+        }
+        return 0.0f;
+    }
+
+    void snap(screen_vertex &v, Edge edge) const
+    {
+        switch (edge)
+        {
+        case Left:
+            v.x = 0.0f;
+            break;
+        case Right:
+            v.x = max_x_;
+            break;
+        case Top:
+            v.y = 0.0f;
+            break;
+        case Bottom:
+            v.y = max_y_;
+            break;
+        }
+    }
+
+    std::size_t clip_edge(const Polygon &input, std::size_t size, Polygon &output,
+                          Edge edge) const
+    {
+        std::size_t output_size = 0;
+        if (size == 0)
+        {
+            return 0;
+        }
+
+        const screen_vertex *previous = &input[size - 1];
+        float previous_distance       = distance(*previous, edge);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            const screen_vertex &current = input[i];
+            const float current_distance = distance(current, edge);
+
+            if ((previous_distance >= 0.0f) != (current_distance >= 0.0f))
+            {
+                const float t           = previous_distance / (previous_distance - current_distance);
+                screen_vertex &crossing = output[output_size++];
+                crossing                = screen_vertex{
+                    .x = previous->x + (current.x - previous->x) * t,
+                    .y = previous->y + (current.y - previous->y) * t,
+                    .z = previous->z + (current.z - previous->z) * t,
+                };
+                // put crossing exactly on edge, rounding errors could move it outside
+                snap(crossing, edge);
+            }
+
+            if (current_distance >= 0.0f)
+            {
+                output[output_size++] = current;
+            }
+
+            previous          = &current;
+            previous_distance = current_distance;
+        }
+        return output_size;
+    }
+
+    float max_x_;
+    float max_y_;
+};
+
+} // namespace msgpu::mode
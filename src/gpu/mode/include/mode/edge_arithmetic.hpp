@@ -0,0 +1,107 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+
+namespace msgpu::mode
+{
+
+/// @brief Edge walker arithmetic on floats
+struct FloatEdgeArithmetic
+{
+    using Type = float;
+
+    /// @brief Small offset used to move edge start, so it rounds towards triangle inside
+    constexpr static Type epsilon = 0.0001f;
+
+    constexpr static Type from_int(int value)
+    {
+        return static_cast<Type>(value);
+    }
+
+    /// @brief Calculates dx/dy step, for horizontal edges dx is returned
+    constexpr static Type slope(int dx, int dy)
+    {
+        return dy != 0 ? static_cast<Type>(dx) / static_cast<Type>(dy) : static_cast<Type>(dx);
+    }
+
+    static uint16_t to_pixel(Type value)
+    {
+        return static_cast<uint16_t>(std::round(value));
+    }
+};
+
+/// @brief Edge walker arithmetic on 16.16 fixed point numbers
+///
+/// @details
+///   RP2040 has no FPU, so each float operation is a call to soft-float library.
+///   With fixed point edges stepping costs single integer addition.
+///   16 bits of integer part is enough for any supported resolution.
+struct FixedEdgeArithmetic
+{
+    using Type = int32_t;
+
+    constexpr static int fraction_bits = 16;
+    constexpr static Type one          = Type{1} << fraction_bits;
+    constexpr static Type half         = one >> 1;
+    constexpr static Type epsilon      = 7; // ~0.0001
+
+    constexpr static Type from_int(int value)
+    {
+        return static_cast<Type>(value) * one;
+    }
+
+    /// @brief Calculates dx/dy step, for horizontal edges dx is returned
+    constexpr static Type slope(int dx, int dy)
+    {
+        return dy != 0 ? from_int(dx) / dy : from_int(dx);
+    }
+
+    constexpr static uint16_t to_pixel(Type value)
+    {
+        // arithmetic shift rounds negative numbers towards -infinity,
+        // so rounding is symmetric only for non-negative values, which are only visible ones
+        return static_cast<uint16_t>((value + half) >> fraction_bits);
+    }
+};
+
+/// @brief Selects edge arithmetic for mode configuration
+///
+/// @details
+///   Fixed point arithmetic is used when Configuration defines
+///   constexpr static bool fixed_point_edges = true, floats otherwise.
+template <typename Configuration>
+struct EdgeArithmeticSelector
+{
+    constexpr static bool fixed_point = []() {
+        if constexpr (requires { Configuration::fixed_point_edges; })
+        {
+            return static_cast<bool>(Configuration::fixed_point_edges);
+        }
+        return false;
+    }();
+
+    using type = std::conditional_t<fixed_point, FixedEdgeArithmetic, FloatEdgeArithmetic>;
+};
+
+template <typename Configuration>
+using EdgeArithmetic = typename EdgeArithmeticSelector<Configuration>::type;
+
+} // namespace msgpu::mode
@@ -17,14 +17,19 @@
 #pragma once
 
 #include "mode/framebuffer.hpp"
+#include "mode/render_core.hpp"
 
+#include <algorithm>
 #include <cstring>
+#include <limits>
 
 #include "messages/ack.hpp"
 #include "messages/clear_screen.hpp"
 #include "messages/swap_buffer.hpp"
 
 #include "memory/gpuram.hpp"
+#include "memory/line_codec.hpp"
+#include "memory/pixel_format.hpp"
 #include "memory/vram.hpp"
 
 #include "generator/vga.hpp"
@@ -41,17 +46,26 @@ class ModeBase
   public:
     virtual ~ModeBase() = default;
 
+    /// @param render_core - core which rasterizes frames, frames are rendered in place if null
     ModeBase(memory::VideoRam &framebuffer, memory::GpuRAM &gpuram, I2CType &i2c,
-             io::UsartPoint &point)
+             io::UsartPoint &point, RenderCore *render_core = nullptr)
         : buffer_id_(1)
         , clear_color_(0)
+        , build_list_(0)
+        , render_list_(0)
         , framebuffer_(framebuffer)
         , gpuram_(gpuram)
+        , transfer_buffer_index_(0)
+        , burst_first_line_(0)
+        , burst_size_(0)
+        , back_buffer_id_(1)
         , i2c_(i2c)
         , point_(point)
-
+        , render_core_(render_core)
     {
         clear_screen();
+        set_framebuffer_format();
+        reset_line_signatures();
     }
 
     virtual void clear() = 0;
@@ -63,12 +77,74 @@ class ModeBase
         clear();
     }
 
+    /// @brief Completes display list and passes it to render core
+    ///
+    /// @details
+    ///   Messages of next frame are processed while frame is rendered,
+    ///   Ack is sent when frame is presented.
     void process(const SwapBuffer &)
     {
         // log::Log::trace("Swap buffer");
-        uint8_t read_buf_id = buffer_id_;
-        buffer_id_          = buffer_id_ ? 0 : 1;
-        render();
+        const uint8_t read_buf_id = buffer_id_;
+        buffer_id_                = buffer_id_ ? 0 : 1;
+        prepare_frame();
+
+        const uint8_t list = build_list_;
+        if (render_core_ == nullptr)
+        {
+            present_frame(list, read_buf_id);
+        }
+        else
+        {
+            render_core_->submit([this, list, read_buf_id] { present_frame(list, read_buf_id); });
+        }
+        start_next_list();
+    }
+
+    void process(const ChangeMode &req)
+    {
+        log::Log::info("Change mode to: %d", req.mode);
+    }
+
+    /// @brief Renders display list which is built now, without render core
+    ///
+    /// @details
+    ///   Frame isn't presented, display list is cleared afterwards.
+    ///   Must not be used when frames are rendered by render core.
+    void render()
+    {
+        prepare_frame();
+        render_list_ = build_list_;
+        render_frame();
+        reset_display_list();
+    }
+
+  protected:
+    /// @brief Number of display lists, one is built while other is rendered
+    constexpr static std::size_t display_lists = 2;
+
+    /// @brief Finishes build display list before it is rendered, called on parse core
+    virtual void prepare_frame()
+    {
+    }
+
+    /// @brief Rasterizes display list selected by render_list_, called on render core
+    virtual void render_frame() = 0;
+
+    /// @brief Clears build display list
+    virtual void reset_display_list()
+    {
+        reset_line_signatures();
+    }
+
+    /// @brief Renders display list and shows it on screen, called on render core
+    void present_frame(uint8_t list, uint8_t read_buf_id)
+    {
+        render_list_ = list;
+        render_frame();
+        // RAMDAC may read buffer only when all lines are in memory
+        flush_lines();
+        framebuffer_.wait_for_write();
 
         const uint8_t cmd[] = {0x03, read_buf_id};
 
@@ -79,32 +155,367 @@ class ModeBase
 
         this->point_.write(Ack{});
 
-        framebuffer_.select_buffer(buffer_id_, read_buf_id);
+        framebuffer_.select_buffer(read_buf_id ? 0 : 1, read_buf_id);
     }
 
-    void process(const ChangeMode &req)
+    /// @brief Switches to next display list, waits until frame which used it is presented
+    void start_next_list()
     {
-        log::Log::info("Change mode to: %d", req.mode);
+        build_list_ = static_cast<uint8_t>((build_list_ + 1) % display_lists);
+        if (render_core_)
+        {
+            render_core_->wait_for_pending(display_lists - 1);
+        }
+        reset_display_list();
+    }
+
+    /// @brief Waits until all submitted frames are presented
+    void wait_for_render()
+    {
+        if (render_core_)
+        {
+            render_core_->wait_idle();
+        }
+    }
+
+    /// @brief Sends response after all pending frames, so Acks keep order of requests
+    template <typename T>
+    void respond(const T &msg)
+    {
+        wait_for_render();
+        point_.write(msg);
     }
-    virtual void render() = 0;
 
-  protected:
     void clear_screen()
     {
     }
 
+    /// @brief Negotiates framebuffer format with RAMDAC
+    ///
+    /// @details
+    ///   Framebuffer uses smallest format which holds colour depth of mode,
+    ///   RAMDAC must switch to the same format before first frame is displayed.
+    ///   Compressed line format is used when mode enables it.
+    void set_framebuffer_format()
+    {
+        // content of both buffers is unknown from now
+        for (auto &signatures : buffer_signatures_)
+        {
+            std::fill(std::begin(signatures), std::end(signatures), 0u);
+        }
+
+        framebuffer_.set_resolution(Configuration::resolution_width,
+                                    Configuration::resolution_height);
+        framebuffer_.set_color_space(static_cast<uint8_t>(pixel_format));
+        framebuffer_.set_compression(compressed_framebuffer);
+
+        const uint8_t cmd[] = {0x04, static_cast<uint8_t>(pixel_format),
+                               static_cast<uint8_t>(compressed_framebuffer)};
+        this->i2c_.write(0x2e, cmd);
+
+        uint8_t ack[2] = {};
+        this->i2c_.read(ack);
+        if (ack[0] != 0xac || ack[1] != 0x88)
+        {
+            log::Log::error("RAMDAC didn't accept framebuffer format: %d",
+                            static_cast<int>(pixel_format));
+        }
+    }
+
     union LineBuffer {
         uint8_t u8[1024];
         uint16_t u16[1024 / 2];
+        uint32_t u32[1024 / 4];
+    };
+
+    constexpr static memory::PixelFormat pixel_format =
+        memory::select_pixel_format(Configuration::bits_per_pixel);
+
+    /// @brief Number of pixels rendered in line buffer
+    constexpr static std::size_t line_width =
+        std::min(Configuration::resolution_width, sizeof(LineBuffer::u16) / sizeof(uint16_t));
+
+    /// @brief Size of line converted to framebuffer format
+    constexpr static std::size_t packed_line_size =
+        memory::packed_line_size(line_width, pixel_format);
+
+    constexpr static bool is_framebuffer_compressed()
+    {
+        if constexpr (requires { Configuration::compressed_framebuffer; })
+        {
+            return Configuration::compressed_framebuffer;
+        }
+        return false;
+    }
+
+    /// @brief Mode may store framebuffer lines compressed, see VideoRam::set_compression()
+    constexpr static bool compressed_framebuffer = is_framebuffer_compressed();
+
+    /// @brief Size of line prepared for transfer
+    constexpr static std::size_t transfer_line_size =
+        compressed_framebuffer ? memory::encoded_line_capacity(packed_line_size)
+                               : packed_line_size;
+
+    /// @brief Number of consecutive lines sent to framebuffer in single burst
+    constexpr static std::size_t lines_per_burst = 4;
+
+    static_assert(lines_per_burst <= memory::VideoRam::max_lines_per_write,
+                  "Burst doesn't fit in single VideoRam write");
+
+    /// @brief Packed lines used in turns, one burst is rendered while other is transferred
+    constexpr static std::size_t transfer_buffers_count = 2 * lines_per_burst;
+
+    /// @brief Fills pixels from x0 to x1 (inclusive) in line buffer with single colour
+    ///
+    /// @details
+    ///   Pixels are stored in pairs with word-wide stores,
+    ///   only unaligned ends are written separately.
+    void fill_span(uint16_t x0, uint16_t x1, uint16_t color)
+    {
+        std::size_t x         = x0;
+        const std::size_t end = static_cast<std::size_t>(x1) + 1;
+        if (x & 1 && x < end)
+        {
+            line_buffer_.u16[x++] = color;
+        }
+
+        const uint32_t pair = static_cast<uint32_t>(color) << 16 | color;
+        for (; x + 1 < end; x += 2)
+        {
+            line_buffer_.u32[x / 2] = pair;
+        }
+
+        if (x < end)
+        {
+            line_buffer_.u16[x] = color;
+        }
+    }
+
+    /// @brief Converts line buffer to framebuffer format and queues it for transfer
+    ///
+    /// @details
+    ///   Lines are encoded when framebuffer is compressed.
+    ///   Lines must be written in order. When burst is full, it is transferred
+    ///   without waiting, next burst is rendered during transfer.
+    ///   VideoRam finishes transfer before it starts next one, so transfer buffers
+    ///   are free when they are used again.
+    void write_line(uint16_t line)
+    {
+        // skipped lines break burst, lines in burst must be consecutive
+        if (burst_size_ != 0 && static_cast<std::size_t>(line) != burst_first_line_ + burst_size_)
+        {
+            flush_lines();
+        }
+
+        if (burst_size_ == 0)
+        {
+            burst_first_line_ = line;
+        }
+        buffer_signatures_[back_buffer_id_][line] = line_lists_[render_list_].signatures[line];
+
+        const std::span<const uint16_t> pixels(line_buffer_.u16, line_width);
+        const std::span<uint8_t> transfer(transfer_buffers_[transfer_buffer_index_]);
+        if constexpr (compressed_framebuffer)
+        {
+            memory::pack_line(pixels, pixel_format, packed_line_);
+            const std::size_t size      = memory::encode_line(packed_line_, transfer);
+            burst_lines_[burst_size_++] = transfer.first(size);
+        }
+        else
+        {
+            memory::pack_line(pixels, pixel_format, transfer);
+            burst_lines_[burst_size_++] = transfer;
+        }
+        transfer_buffer_index_      = (transfer_buffer_index_ + 1) % transfer_buffers_count;
+
+        if (burst_size_ == lines_per_burst)
+        {
+            flush_lines();
+        }
+    }
+
+    /// @brief Starts transfer of queued lines
+    void flush_lines()
+    {
+        if (burst_size_ == 0)
+        {
+            return;
+        }
+
+        framebuffer_.write_lines_async(burst_first_line_, std::span(burst_lines_, burst_size_));
+        burst_size_ = 0;
+    }
+
+    void clear_depth_buffer()
+    {
+        std::fill(std::begin(depth_buffer_), std::end(depth_buffer_),
+                  std::numeric_limits<float>::infinity());
+    }
+
+    /// @brief Tests fragment depth against current line depth buffer
+    ///
+    /// @details
+    ///   Fragment passes when it is closer than already drawn one,
+    ///   then depth buffer is updated.
+    ///
+    /// @returns true if fragment is visible
+    bool depth_test(std::size_t x, float z)
+    {
+        if (z < depth_buffer_[x])
+        {
+            depth_buffer_[x] = z;
+            return true;
+        }
+        return false;
+    }
+
+    /// @brief Where content of line is taken from during rendering
+    enum class LineSource : uint8_t
+    {
+        Render,      ///< line must be rasterized
+        BackBuffer,  ///< written buffer already holds the same line
+        FrontBuffer, ///< other buffer holds the same line, it is copied
+    };
+
+    constexpr static uint32_t signature_basis = 2166136261u;
+
+    /// @brief Mixes value into signature byte by byte (FNV-1a)
+    constexpr static uint32_t mix_signature(uint32_t signature, uint32_t value)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            signature = (signature ^ ((value >> (i * 8)) & 0xff)) * 16777619u;
+        }
+        return signature;
+    }
+
+    static uint32_t background_signature(uint8_t clear_color)
+    {
+        return mix_signature(signature_basis, clear_color);
+    }
+
+    /// @brief Starts collection of line signatures for next frame
+    ///
+    /// @details
+    ///   Signature of line combines clear colour with all primitives touching the line,
+    ///   in submission order. Line with signature equal to one stored in framebuffer
+    ///   doesn't have to be rendered again.
+    void reset_line_signatures()
+    {
+        LineList &lines   = line_lists_[build_list_];
+        lines.clear_color = clear_color_;
+        std::fill(std::begin(lines.signatures), std::end(lines.signatures),
+                  background_signature(clear_color_));
+    }
+
+    /// @brief Adds primitive covering lines from first to last (inclusive) to signatures
+    void mark_lines(int first, int last, uint32_t primitive_signature)
+    {
+        constexpr int height = static_cast<int>(Configuration::resolution_height);
+        uint32_t *signatures = line_lists_[build_list_].signatures;
+        for (int line = std::max(first, 0); line <= std::min(last, height - 1); ++line)
+        {
+            signatures[line] = mix_signature(signatures[line], primitive_signature);
+        }
+    }
+
+    /// @brief Forces rendering of line which content is not described by signature
+    void invalidate_line(uint16_t line)
+    {
+        line_lists_[render_list_].signatures[line] = 0;
+    }
+
+    /// @brief Adds state used by primitives of rendered frame to signature of line
+    ///
+    /// @details
+    ///   State known only on render core, like colour of flat shading,
+    ///   must be added before line_source() is checked.
+    void mix_render_state(uint16_t line, uint32_t state)
+    {
+        uint32_t &signature = line_lists_[render_list_].signatures[line];
+        signature           = mix_signature(signature, state);
+    }
+
+    bool has_primitives(uint16_t line) const
+    {
+        const LineList &lines = line_lists_[render_list_];
+        return lines.signatures[line] != background_signature(lines.clear_color);
+    }
+
+    /// @returns background colour of rendered display list
+    uint8_t render_clear_color() const
+    {
+        return line_lists_[render_list_].clear_color;
+    }
+
+    /// @brief Selects buffer written in current frame, must be called before first line
+    void begin_frame()
+    {
+        back_buffer_id_ = framebuffer_.get_write_buffer_id() ? 1 : 0;
+    }
+
+    LineSource line_source(uint16_t line) const
+    {
+        const uint32_t signature = line_lists_[render_list_].signatures[line];
+        if (signature == 0)
+        {
+            return LineSource::Render;
+        }
+        if (buffer_signatures_[back_buffer_id_][line] == signature)
+        {
+            return LineSource::BackBuffer;
+        }
+        if (buffer_signatures_[front_buffer_id()][line] == signature)
+        {
+            return LineSource::FrontBuffer;
+        }
+        return LineSource::Render;
+    }
+
+    /// @brief Copies line from front buffer instead of rendering it
+    void copy_line(uint16_t line)
+    {
+        // copy is synchronous, queued lines must be written before it
+        flush_lines();
+        framebuffer_.copy_line(front_buffer_id(), back_buffer_id_, line);
+        buffer_signatures_[back_buffer_id_][line] = line_lists_[render_list_].signatures[line];
+    }
+
+    uint8_t front_buffer_id() const
+    {
+        return back_buffer_id_ ? 0 : 1;
+    }
+
+    /// @brief Line signatures of frame, collected with display list
+    struct LineList
+    {
+        uint32_t signatures[Configuration::resolution_height];
+        uint8_t clear_color;
     };
 
     uint8_t buffer_id_;
     uint8_t clear_color_;
+    // list filled by processed messages (parse core) and list rasterized by render core
+    uint8_t build_list_;
+    uint8_t render_list_;
     memory::VideoRam &framebuffer_;
     memory::GpuRAM &gpuram_;
     LineBuffer line_buffer_;
+    uint8_t packed_line_[packed_line_size];
+    uint8_t transfer_buffers_[transfer_buffers_count][transfer_line_size];
+    std::size_t transfer_buffer_index_;
+    memory::VideoRam::ConstDataType<uint8_t> burst_lines_[lines_per_burst];
+    uint16_t burst_first_line_;
+    std::size_t burst_size_;
+    uint8_t back_buffer_id_;
+    // signatures of lines in display lists and of lines stored in both buffers, 0 is unknown
+    LineList line_lists_[display_lists];
+    uint32_t buffer_signatures_[2][Configuration::resolution_height];
+    // depth is tested per line, so single line fits in SRAM
+    float depth_buffer_[Configuration::resolution_width];
     I2CType &i2c_;
     io::UsartPoint &point_;
+    RenderCore *render_core_;
 };
 
 } // namespace msgpu::mode
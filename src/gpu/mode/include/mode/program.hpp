@@ -35,6 +35,9 @@ constexpr std::size_t MAX_MODULES_LIST_SIZE = 10;
 class Program
 {
   public:
+    using SpanShader        = void();
+    using VertexBatchShader = void();
+
     Program();
 
     bool assign_module(const Module &module);
@@ -45,6 +48,26 @@ class Program
     const msos::dl::LoadedModule *pixel_shader() const;
     const msos::dl::LoadedModule *vertex_shader() const;
 
+    /// @brief Span-batched entry point of pixel shader
+    ///
+    /// @returns shade_span exported by pixel shader module or nullptr, then main is executed
+    ///          for each pixel
+    SpanShader *span_shader() const;
+
+    /// @brief Batched entry point of vertex shader
+    ///
+    /// @returns shade_vertices exported by vertex shader module or nullptr, then main is
+    ///          executed for each vertex
+    VertexBatchShader *vertex_batch_shader() const;
+
+    /// @brief Marks pixel shader as producing same colour for whole primitive
+    ///
+    /// @details
+    ///   Constant pixel shader is evaluated once per frame,
+    ///   and spans are filled without per-pixel shader calls.
+    void set_constant_pixel_shader(bool constant);
+    bool constant_pixel_shader() const;
+
     void delete_parameter_by_id(uint8_t id);
     void delete_parameter_by_name(std::string_view name);
 
@@ -56,6 +79,9 @@ class Program
 
     const msos::dl::LoadedModule *vertex_shader_;
     const msos::dl::LoadedModule *pixel_shader_;
+    SpanShader *span_shader_;
+    VertexBatchShader *vertex_batch_shader_;
+    bool constant_pixel_shader_;
     IndexedBuffer<NamedParameter, 5, uint8_t> named_parameters_;
 };
 
@@ -0,0 +1,125 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include <eul/functional/function.hpp>
+
+#include "io/spsc_queue.hpp"
+
+#include "sync.hpp"
+
+namespace msgpu::mode
+{
+
+/// @brief Executes rendering jobs on second core
+///
+/// @details
+///   Core which processes messages (parse core) builds display list of next frame,
+///   while render core rasterizes completed one. Jobs are passed via lock-free ring,
+///   so parse core blocks only when all display lists are in use.
+///   Jobs are executed in submission order by run(), which never returns.
+///   Counters have single writer each (submitted by parse core, finished by render core),
+///   so only plain loads and stores are used. Waiting core sleeps in WFE until other core
+///   signals progress with SEV.
+class RenderCore
+{
+  public:
+    using Job = eul::function<void(), 2 * sizeof(void *)>;
+
+    /// @brief Maximal number of jobs waiting for execution
+    constexpr static std::size_t max_jobs = 2;
+
+    /// @brief Queues job, waits when queue is full
+    void submit(const Job &job)
+    {
+        while (!jobs_.push(job))
+        {
+            wait_for_pending(max_jobs - 1);
+        }
+        increment(submitted_);
+        __sev();
+    }
+
+    /// @brief Waits until at most given number of submitted jobs is not finished
+    void wait_for_pending(uint32_t jobs)
+    {
+        const uint32_t submitted = submitted_.load(std::memory_order_acquire);
+        while (submitted - finished_.load(std::memory_order_acquire) > jobs)
+        {
+            __wfe();
+        }
+    }
+
+    /// @brief Waits until all submitted jobs are finished
+    void wait_idle()
+    {
+        wait_for_pending(0);
+    }
+
+    bool idle() const
+    {
+        return submitted_.load(std::memory_order_acquire) ==
+               finished_.load(std::memory_order_acquire);
+    }
+
+    /// @brief Executes single queued job
+    ///
+    /// @returns false if queue was empty
+    bool process_job()
+    {
+        Job *job = jobs_.front();
+        if (job == nullptr)
+        {
+            return false;
+        }
+
+        (*job)();
+        jobs_.pop();
+        increment(finished_);
+        __sev();
+        return true;
+    }
+
+    /// @brief Main loop of render core, sleeps when there is nothing to render
+    [[noreturn]] void run()
+    {
+        while (true)
+        {
+            while (process_job())
+            {
+            }
+            // submission after queue check leaves event set, so WFE returns immediately
+            __wfe();
+        }
+    }
+
+  private:
+    /// @brief Increments counter which is written only by calling core
+    static void increment(std::atomic<uint32_t> &counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    io::SpscQueue<Job, max_jobs> jobs_;
+    std::atomic<uint32_t> submitted_{0};
+    std::atomic<uint32_t> finished_{0};
+};
+
+} // namespace msgpu::mode
@@ -0,0 +1,39 @@
+/*
+ *   Copyright (c) 2021 Mateusz Stadnik
+
+ *   This program is free software: you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation, either version 3 of the License, or
+ *   (at your option) any later version.
+
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <shader/globals.hpp>
+#include <shader/vec3.hpp>
+#include <shader/vec4.hpp>
+
+// Batched shader entry points are staged in shader/ directory, they are used once
+// msgpu_interface provides descriptors, until then shaders are executed through main
+
+#if __has_include(<shader/span.hpp>)
+#include <shader/span.hpp>
+#define MSGPU_SHADER_SPAN 1
+#else
+#define MSGPU_SHADER_SPAN 0
+#endif
+
+#if __has_include(<shader/vertex_batch.hpp>)
+#include <shader/vertex_batch.hpp>
+#define MSGPU_SHADER_VERTEX_BATCH 1
+#else
+#define MSGPU_SHADER_VERTEX_BATCH 0
+#endif
@@ -27,16 +27,22 @@ class TextMode : public ModeBase<Configuration, I2CType>
 {
   public:
     TextMode(memory::VideoRam &framebuffer, memory::GpuRAM &gpuram, I2CType &i2c,
-             io::UsartPoint &point)
-        : ModeBase<Configuration, I2CType>(framebuffer, gpuram, i2c, point)
+             io::UsartPoint &point, RenderCore *render_core = nullptr)
+        : ModeBase<Configuration, I2CType>(framebuffer, gpuram, i2c, point, render_core)
     {
     }
 
+    ~TextMode() override
+    {
+        this->wait_for_render();
+    }
+
     void clear() override
     {
     }
 
-    void render() override
+  protected:
+    void render_frame() override
     {
     }
 };
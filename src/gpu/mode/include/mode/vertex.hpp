@@ -29,5 +29,22 @@ struct vertex_2d
     uint16_t y;
 };
 
+/// @brief Projected vertex before perspective divide
+struct clip_vertex
+{
+    float x;
+    float y;
+    float z;
+    float w;
+};
+
+/// @brief Vertex in screen coordinates with depth, before rasterization
+struct screen_vertex
+{
+    float x;
+    float y;
+    float z;
+};
+
 } // namespace mode
 } // namespace msgpu
@@ -19,6 +19,8 @@
 
 #include <cstdint>
 
+#include <shader/globals.hpp>
+
 namespace msgpu::mode
 {
 
@@ -33,4 +35,10 @@ struct VertexAttribute
     uint32_t offset;
 };
 
+/// @brief State of vertex array object
+struct VertexArrayState
+{
+    VertexAttribute attributes[shader_in_arguments_size];
+};
+
 } // namespace msgpu::mode
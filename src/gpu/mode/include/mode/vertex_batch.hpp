@@ -0,0 +1,182 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "mode/shader_interface.hpp"
+#include "mode/vertex_attribute.hpp"
+
+namespace msgpu::mode
+{
+
+/// @brief Block of vertices loaded from GPU RAM as structure of arrays
+///
+/// @details
+///   Each attribute stream is fetched with as few reads as possible,
+///   interleaved data is read in bulk into scratch buffer and then split into
+///   attribute arrays, so QSPI transaction setup is paid once per batch
+///   instead of once per vertex and attribute.
+///   When buffers support gather, packed attributes are requested together,
+///   so memory can merge and chain their transfers.
+///
+/// @tparam batch_size - maximal number of vertices in batch
+template <std::size_t batch_size>
+class VertexBatch
+{
+  public:
+    constexpr static std::size_t max_attribute_size = 4 * sizeof(float);
+    constexpr static std::size_t attributes_count   = shader_in_arguments_size;
+
+    /// @brief Loads vertices from GPU buffers
+    ///
+    /// @param buffers - GPU buffers with vertex data
+    /// @param attributes - vertex attributes, only used ones are loaded
+    /// @param first - index of first vertex
+    /// @param count - number of vertices, must not exceed batch_size
+    template <typename Buffers>
+    void load(Buffers &buffers, const VertexAttribute *attributes, uint32_t first,
+              std::size_t count)
+    {
+        count_ = std::min(count, batch_size);
+        if constexpr (requires { typename Buffers::BufferRead; })
+        {
+            using BufferRead = typename Buffers::BufferRead;
+            BufferRead reads[attributes_count];
+            std::size_t gathered = 0;
+            for (std::size_t i = 0; i < attributes_count; ++i)
+            {
+                sizes_[i] = 0;
+                if (!attributes[i].used)
+                {
+                    continue;
+                }
+
+                const std::size_t size = attributes[i].size * sizeof(float);
+                if (size != 0 && (attributes[i].stride == 0 || attributes[i].stride == size))
+                {
+                    sizes_[i]         = static_cast<int>(size);
+                    reads[gathered++] = BufferRead{attributes[i].buffer, streams_[i], size * count_,
+                                                   attributes[i].offset + size * first};
+                    continue;
+                }
+                load_attribute(buffers, attributes[i], i, first);
+            }
+            buffers.read(std::span<const BufferRead>(reads, gathered));
+        }
+        else
+        {
+            for (std::size_t i = 0; i < attributes_count; ++i)
+            {
+                sizes_[i] = 0;
+                if (attributes[i].used)
+                {
+                    load_attribute(buffers, attributes[i], i, first);
+                }
+            }
+        }
+    }
+
+    std::size_t size() const
+    {
+        return count_;
+    }
+
+    /// @brief Points shader input arguments to attributes of vertex
+    void set_arguments(std::size_t vertex, void **arguments)
+    {
+        for (std::size_t i = 0; i < attributes_count; ++i)
+        {
+            arguments[i] = &streams_[i][vertex * static_cast<std::size_t>(sizes_[i])];
+        }
+    }
+
+#if MSGPU_SHADER_VERTEX_BATCH
+    /// @brief Describes loaded vertices for batched vertex shader
+    ShaderVertexBatch descriptor()
+    {
+        for (std::size_t i = 0; i < attributes_count; ++i)
+        {
+            inputs_[i] = streams_[i];
+        }
+
+        return ShaderVertexBatch{
+            .count       = static_cast<int>(count_),
+            .inputs      = inputs_,
+            .input_sizes = sizes_,
+            .positions   = positions,
+            .colors      = colors,
+        };
+    }
+#endif
+
+    vec4 positions[batch_size];
+    vec3 colors[batch_size];
+
+  private:
+    constexpr static std::size_t scratch_size = 1024;
+
+    template <typename Buffers>
+    void load_attribute(Buffers &buffers, const VertexAttribute &attribute, std::size_t index,
+                        uint32_t first)
+    {
+        const std::size_t size   = attribute.size * sizeof(float);
+        const std::size_t stride = attribute.stride == 0 ? size : attribute.stride;
+        sizes_[index]            = static_cast<int>(size);
+
+        if (size == 0)
+        {
+            return;
+        }
+
+        if (stride == size)
+        {
+            // tightly packed attribute is already in SoA layout
+            buffers.read(attribute.buffer, streams_[index], size * count_,
+                         attribute.offset + stride * first);
+            return;
+        }
+
+        // interleaved attribute, read as many vertices as fits in scratch at once
+        const std::size_t per_read = (scratch_size - size) / stride + 1;
+        for (std::size_t vertex = 0; vertex < count_; vertex += per_read)
+        {
+            const std::size_t vertices = std::min(per_read, count_ - vertex);
+            buffers.read(attribute.buffer, scratch_, stride * (vertices - 1) + size,
+                         attribute.offset + stride * (first + vertex));
+
+            for (std::size_t i = 0; i < vertices; ++i)
+            {
+                std::memcpy(&streams_[index][(vertex + i) * size], &scratch_[i * stride], size);
+            }
+        }
+    }
+
+    std::size_t count_ = 0;
+    uint8_t streams_[attributes_count][batch_size * max_attribute_size];
+    uint8_t scratch_[scratch_size];
+    int sizes_[attributes_count];
+#if MSGPU_SHADER_VERTEX_BATCH
+    void *inputs_[attributes_count];
+#endif
+};
+
+} // namespace msgpu::mode
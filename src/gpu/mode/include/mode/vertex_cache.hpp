@@ -0,0 +1,127 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "mode/vertex.hpp"
+
+namespace msgpu::mode
+{
+
+/// @brief Vertex after vertex shader and projection, perspective divide is done after clipping
+struct TransformedVertex
+{
+    clip_vertex position;
+    uint16_t color;
+};
+
+/// @brief Post-transform vertex cache
+///
+/// @details
+///   Direct mapped cache keyed by buffer id and vertex index.
+///   Hit is counted when cached vertex is found, miss when vertex
+///   had to be transformed and was inserted to cache.
+///
+/// @tparam size - number of cached vertices, must be power of 2
+template <std::size_t size>
+class VertexCache
+{
+  public:
+    static_assert((size & (size - 1)) == 0, "Size must be power of 2");
+
+    VertexCache()
+    {
+        clear();
+        reset_statistics();
+    }
+
+    const TransformedVertex *find(uint16_t buffer, uint32_t index)
+    {
+        const Entry &entry = entries_[slot(buffer, index)];
+        if (!entry.valid || entry.buffer != buffer || entry.index != index)
+        {
+            return nullptr;
+        }
+        ++hits_;
+        return &entry.vertex;
+    }
+
+    bool contains(uint16_t buffer, uint32_t index) const
+    {
+        const Entry &entry = entries_[slot(buffer, index)];
+        return entry.valid && entry.buffer == buffer && entry.index == index;
+    }
+
+    void insert(uint16_t buffer, uint32_t index, const TransformedVertex &vertex)
+    {
+        entries_[slot(buffer, index)] = Entry{
+            .valid  = true,
+            .buffer = buffer,
+            .index  = index,
+            .vertex = vertex,
+        };
+        ++misses_;
+    }
+
+    void clear()
+    {
+        for (auto &entry : entries_)
+        {
+            entry.valid = false;
+        }
+    }
+
+    std::size_t hits() const
+    {
+        return hits_;
+    }
+
+    std::size_t misses() const
+    {
+        return misses_;
+    }
+
+    void reset_statistics()
+    {
+        hits_   = 0;
+        misses_ = 0;
+    }
+
+  private:
+    struct Entry
+    {
+        bool valid;
+        uint16_t buffer;
+        uint32_t index;
+        TransformedVertex vertex;
+    };
+
+    static std::size_t slot(uint16_t buffer, uint32_t index)
+    {
+        // consecutive indices land in consecutive slots, buffers are spread across cache
+        return (index + static_cast<std::size_t>(buffer) * 0x9e37) & (size - 1);
+    }
+
+    std::array<Entry, size> entries_;
+    std::size_t hits_;
+    std::size_t misses_;
+};
+
+} // namespace msgpu::mode
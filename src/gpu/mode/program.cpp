@@ -23,6 +23,9 @@ namespace msgpu::mode
 Program::Program()
     : vertex_shader_(nullptr)
     , pixel_shader_(nullptr)
+    , span_shader_(nullptr)
+    , vertex_batch_shader_(nullptr)
+    , constant_pixel_shader_(false)
     , named_parameters_{}
 {
 }
@@ -31,11 +34,21 @@ bool Program::assign_module(const Module &module)
 {
     if (module.type == ModuleType::VertexShader)
     {
-        vertex_shader_ = module.module;
+        vertex_shader_       = module.module;
+        vertex_batch_shader_ = nullptr;
+        if (vertex_shader_)
+        {
+            vertex_batch_shader_ = vertex_shader_->find_symbol<VertexBatchShader>("shade_vertices");
+        }
     }
     if (module.type == ModuleType::PixelShader)
     {
         pixel_shader_ = module.module;
+        span_shader_  = nullptr;
+        if (pixel_shader_)
+        {
+            span_shader_ = pixel_shader_->find_symbol<SpanShader>("shade_span");
+        }
     }
     return true;
 }
@@ -77,6 +90,26 @@ const msos::dl::LoadedModule *Program::vertex_shader() const
     return vertex_shader_;
 }
 
+Program::SpanShader *Program::span_shader() const
+{
+    return span_shader_;
+}
+
+Program::VertexBatchShader *Program::vertex_batch_shader() const
+{
+    return vertex_batch_shader_;
+}
+
+void Program::set_constant_pixel_shader(bool constant)
+{
+    constant_pixel_shader_ = constant;
+}
+
+bool Program::constant_pixel_shader() const
+{
+    return constant_pixel_shader_;
+}
+
 void Program::delete_parameter_by_id(uint8_t id)
 {
     if (named_parameters_.test(id))
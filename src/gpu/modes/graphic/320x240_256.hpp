@@ -40,6 +40,7 @@ public:
 
     constexpr static Modes mode = Modes::Graphic_320x240_12bit;
     constexpr static bool double_buffered = true;
+    constexpr static bool fixed_point_edges = true;
     
     enum Color : ColorType {
         black = 0x00, 
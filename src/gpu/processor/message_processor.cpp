@@ -24,11 +24,26 @@ namespace processor
 
 MessageProcessor::MessageProcessor() 
     : handlers_{}
+    , bulk_handlers_{}
 {
 }
 
 void MessageProcessor::process_message(const io::Message& message)
 {
+    if (message.bulk != io::BulkKind::None)
+    {
+        BulkHandlerType& bulk_handler = bulk_handlers_[static_cast<std::size_t>(message.bulk)];
+        if (bulk_handler)
+        {
+            bulk_handler(message.bulk_data);
+        }
+        else
+        {
+            printf("Unhandled bulk data kind: %d\n", static_cast<int>(message.bulk));
+        }
+        return;
+    }
+
     HandlerType& handler = handlers_[message.header.id];
     if (handler)
     {
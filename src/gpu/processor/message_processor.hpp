@@ -17,6 +17,7 @@
 #pragma once
 
 #include <array>
+#include <span>
 
 #include <eul/functional/function.hpp>
 
@@ -56,6 +57,35 @@ struct HandlerBinder
     BindedType *self_;
 };
 
+/// @brief Binds bulk data handling method and object.
+template <typename BindedType, typename BlockType>
+struct BulkHandlerBinder
+{
+    typedef bool (BindedType::*fun)(const BlockType &block);
+
+    /// @brief Constructs binder object
+    ///
+    /// @param f - pointer to member function for handling block
+    /// @param b - pointer to object on which member function will be called
+    BulkHandlerBinder(fun f, BindedType *b)
+        : f_(f)
+        , self_(b)
+    {
+    }
+
+    /// @brief Calls handling function
+    ///
+    /// @param data - data received in bulk frame, wrapped in \ref BlockType
+    bool operator()(std::span<const uint8_t> data) const
+    {
+        return (self_->*f_)(BlockType{.data = data});
+    }
+
+  private:
+    fun f_;
+    BindedType *self_;
+};
+
 /// @brief Registers handlers methods for message ids
 class MessageProcessor
 {
@@ -65,7 +95,7 @@ class MessageProcessor
 
     /// @brief Process message received from io
     ///
-    /// @details Calls handler stored in \ref handlers_.
+    /// @details Calls handler stored in \ref handlers_ or \ref bulk_handlers_ for bulk data.
     void process_message(const io::Message &message);
 
     /// @brief Register message processing function
@@ -79,10 +109,23 @@ class MessageProcessor
             HandlerBinder<std::remove_pointer_t<decltype(obj)>, MessageType>(fun, obj);
     }
 
+    /// @brief Register bulk data processing function
+    ///
+    /// @param fun - pointer to member function for handling block
+    /// @param obj - pointer to object on which member function will be called
+    template <typename BlockType>
+    void register_bulk_handler(auto fun, auto *obj)
+    {
+        bulk_handlers_[static_cast<std::size_t>(BlockType::kind)] =
+            BulkHandlerBinder<std::remove_pointer_t<decltype(obj)>, BlockType>(fun, obj);
+    }
+
   protected:
-    using HandlerType = eul::function<bool(const void *), 2 * sizeof(void *)>;
+    using HandlerType     = eul::function<bool(const void *), 2 * sizeof(void *)>;
+    using BulkHandlerType = eul::function<bool(std::span<const uint8_t>), 2 * sizeof(void *)>;
 
     std::array<HandlerType, 255> handlers_;
+    std::array<BulkHandlerType, 3> bulk_handlers_;
 };
 
 } // namespace processor
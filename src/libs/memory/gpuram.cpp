@@ -16,79 +16,233 @@
 
 #include "memory/gpuram.hpp"
 
-#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
 
 namespace msgpu::memory
 {
 namespace
 {
-constexpr uint16_t page_size = 1024;
+/// Gap skipped by merged read is cheaper than command, address and wait cycles of next one
+constexpr std::size_t max_merge_gap = 32;
+
+std::size_t page_of(std::size_t address)
+{
+    return address / GpuRAM::page_size;
+}
+
 } // namespace
+
 GpuRAM::GpuRAM(QspiPSRAM &memory)
     : memory_(memory)
+    , reads_{}
+    , writes_{}
+    , queued_(0)
+    , copies_{}
+    , copies_count_(0)
+    , staging_{}
+    , staging_used_(0)
 {
 }
 
 std::size_t GpuRAM::write(std::size_t address, const void *data, std::size_t nbyte)
 {
-    AddressInfo a                    = get_address_information(address, nbyte);
-    const std::size_t last_page_size = nbyte - a.bytes_to_align - a.pages * page_size;
-    std::size_t bytes_written        = 0;
-    memory_.write(address + bytes_written,
-                  QspiPSRAM::ConstDataBuffer(static_cast<const uint8_t *>(data), a.bytes_to_align));
-    memory_.wait_for_finish();
-    bytes_written += a.bytes_to_align;
-
-    for (uint16_t i = 0; i < a.pages; ++i)
+    const WriteRequest request{address, data, nbyte};
+    return write(std::span<const WriteRequest>(&request, 1));
+}
+
+std::size_t GpuRAM::read(std::size_t address, void *data, std::size_t nbyte)
+{
+    const ReadRequest request{address, data, nbyte};
+    return read(std::span<const ReadRequest>(&request, 1));
+}
+
+std::size_t GpuRAM::read(std::span<const ReadRequest> requests)
+{
+    std::size_t nbyte = 0;
+    std::size_t i     = 0;
+    while (i < requests.size())
     {
-        memory_.write(address + bytes_written,
-                      QspiPSRAM::ConstDataBuffer(static_cast<const uint8_t *>(data) + bytes_written,
-                                                 page_size));
-        bytes_written += page_size;
-        memory_.wait_for_finish();
+        const ReadRequest &first = requests[i];
+        std::size_t end          = first.address + first.size;
+        std::size_t next         = i + 1;
+        if (first.size != 0 && page_of(first.address) == page_of(end - 1))
+        {
+            while (next < requests.size() && next - i < std::size(copies_))
+            {
+                const ReadRequest &r = requests[next];
+                if (r.size == 0 || r.address < first.address || r.address > end + max_merge_gap ||
+                    page_of(r.address + r.size - 1) != page_of(first.address))
+                {
+                    break;
+                }
+                end = std::max(end, r.address + r.size);
+                ++next;
+            }
+        }
+
+        if (next - i > 1)
+        {
+            queue_merged_read(requests.subspan(i, next - i), first.address, end - first.address);
+        }
+        else
+        {
+            split_pages(first.address, first.size,
+                        [this, &first](std::size_t address, std::size_t offset, std::size_t size) {
+                            queue_read(address, static_cast<uint8_t *>(first.data) + offset, size);
+                        });
+        }
+
+        for (; i < next; ++i)
+        {
+            nbyte += requests[i].size;
+        }
     }
+    flush_reads();
+    return nbyte;
+}
+
+std::size_t GpuRAM::write(std::span<const WriteRequest> requests)
+{
+    std::size_t nbyte = 0;
+    std::size_t i     = 0;
+    while (i < requests.size())
+    {
+        const WriteRequest &first = requests[i];
+        std::size_t end           = first.address + first.size;
+        std::size_t next          = i + 1;
+        if (first.size != 0 && page_of(first.address) == page_of(end - 1))
+        {
+            while (next < requests.size() && next - i < std::size(copies_))
+            {
+                const WriteRequest &r = requests[next];
+                if (r.size == 0 || r.address != end ||
+                    page_of(r.address + r.size - 1) != page_of(first.address))
+                {
+                    break;
+                }
+                end += r.size;
+                ++next;
+            }
+        }
+
+        if (next - i > 1)
+        {
+            queue_merged_write(requests.subspan(i, next - i), first.address, end - first.address);
+        }
+        else
+        {
+            split_pages(
+                first.address, first.size,
+                [this, &first](std::size_t address, std::size_t offset, std::size_t size) {
+                    queue_write(address, static_cast<const uint8_t *>(first.data) + offset, size);
+                });
+        }
 
-    memory_.write(address + bytes_written,
-                  QspiPSRAM::ConstDataBuffer(static_cast<const uint8_t *>(data) + bytes_written,
-                                             last_page_size));
-    memory_.wait_for_finish();
+        for (; i < next; ++i)
+        {
+            nbyte += requests[i].size;
+        }
+    }
+    flush_writes();
     return nbyte;
 }
 
-std::size_t GpuRAM::read(std::size_t address, void *data, std::size_t nbyte)
+template <typename Chunk>
+void GpuRAM::split_pages(std::size_t address, std::size_t size, const Chunk &chunk)
+{
+    std::size_t offset = 0;
+    while (offset < size)
+    {
+        const std::size_t to_page_end = page_size - (address + offset) % page_size;
+        const std::size_t part        = std::min(size - offset, to_page_end);
+        chunk(address + offset, offset, part);
+        offset += part;
+    }
+}
+
+void GpuRAM::queue_read(std::size_t address, uint8_t *data, std::size_t size)
+{
+    if (queued_ == std::size(reads_))
+    {
+        flush_reads();
+    }
+    reads_[queued_++] = QspiPSRAM::ReadRequest{address, QspiPSRAM::DataBuffer(data, size)};
+}
+
+void GpuRAM::queue_merged_read(std::span<const ReadRequest> requests, std::size_t address,
+                               std::size_t size)
 {
-    AddressInfo a                    = get_address_information(address, nbyte);
-    const std::size_t last_page_size = nbyte - a.bytes_to_align - a.pages * page_size;
-    std::size_t bytes_written        = 0;
-    memory_.read(address + bytes_written,
-                 QspiPSRAM::DataBuffer(static_cast<uint8_t *>(data), a.bytes_to_align));
-    memory_.wait_for_finish();
-    bytes_written += a.bytes_to_align;
-    for (uint16_t i = 0; i < a.pages; ++i)
+    // staged chunk must be transferred in the same burst as its copies
+    if (queued_ == std::size(reads_) || staging_used_ + size > page_size ||
+        copies_count_ + requests.size() > std::size(copies_))
+    {
+        flush_reads();
+    }
+
+    uint8_t *staged = staging_ + staging_used_;
+    staging_used_ += size;
+    for (const ReadRequest &r : requests)
     {
-        memory_.read(
-            address + bytes_written,
-            QspiPSRAM::DataBuffer(static_cast<uint8_t *>(data) + bytes_written, page_size));
-        bytes_written += page_size;
+        copies_[copies_count_++] =
+            Copy{static_cast<uint8_t *>(r.data), staged + (r.address - address), r.size};
+    }
+    queue_read(address, staged, size);
+}
+
+void GpuRAM::flush_reads()
+{
+    if (queued_ != 0)
+    {
+        memory_.read(std::span<const QspiPSRAM::ReadRequest>(reads_, queued_));
         memory_.wait_for_finish();
+        queued_ = 0;
     }
 
-    memory_.read(
-        address + bytes_written,
-        QspiPSRAM::DataBuffer(static_cast<uint8_t *>(data) + bytes_written, last_page_size));
-    memory_.wait_for_finish();
-    return nbyte;
+    for (std::size_t i = 0; i < copies_count_; ++i)
+    {
+        std::memcpy(copies_[i].to, copies_[i].from, copies_[i].size);
+    }
+    copies_count_ = 0;
+    staging_used_ = 0;
+}
+
+void GpuRAM::queue_write(std::size_t address, const uint8_t *data, std::size_t size)
+{
+    if (queued_ == std::size(writes_))
+    {
+        flush_writes();
+    }
+    writes_[queued_++] = QspiPSRAM::WriteRequest{address, QspiPSRAM::ConstDataBuffer(data, size)};
 }
 
-GpuRAM::AddressInfo GpuRAM::get_address_information(std::size_t address, std::size_t size)
+void GpuRAM::queue_merged_write(std::span<const WriteRequest> requests, std::size_t address,
+                                std::size_t size)
 {
-    const uint16_t address_mod_page = address % page_size;
-    const uint16_t bytes_to_pageend = address_mod_page == 0 ? 0 : page_size - address % page_size;
-    const uint16_t bytes_to_align   = std::min(static_cast<uint16_t>(size), bytes_to_pageend);
-    return AddressInfo{
-        .bytes_to_align = bytes_to_align,
-        .pages          = static_cast<uint16_t>((size - bytes_to_align) / page_size),
-    };
+    if (queued_ == std::size(writes_) || staging_used_ + size > page_size)
+    {
+        flush_writes();
+    }
+
+    uint8_t *staged = staging_ + staging_used_;
+    staging_used_ += size;
+    for (const WriteRequest &r : requests)
+    {
+        std::memcpy(staged + (r.address - address), r.data, r.size);
+    }
+    queue_write(address, staged, size);
+}
+
+void GpuRAM::flush_writes()
+{
+    if (queued_ != 0)
+    {
+        memory_.write(std::span<const QspiPSRAM::WriteRequest>(writes_, queued_));
+        memory_.wait_for_finish();
+        queued_ = 0;
+    }
+    staging_used_ = 0;
 }
 
 } // namespace msgpu::memory
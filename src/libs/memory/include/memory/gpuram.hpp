@@ -18,6 +18,7 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <span>
 
 #include "memory/psram.hpp"
 
@@ -25,7 +26,13 @@ namespace msgpu::memory
 {
 
 /// @brief Manages PSRAM module for GPU memory
-
+///
+/// @details
+///   Transfers are split at device page boundaries and queued to PSRAM in bursts
+///   sent with single bus acquisition. Write chunks of a burst are sent by one DMA chain,
+///   read chunks are issued one after another, each awaited before the next one.
+///   Small requests placed close to each other within single page are merged
+///   into single QSPI command and scattered to destinations after transfer.
 class GpuRAM
 {
   public:
@@ -53,22 +60,75 @@ class GpuRAM
     /// @returns size of readed data
     std::size_t read(std::size_t address, void *data, std::size_t nbyte);
 
-  private:
-    struct AddressInfo
+    struct ReadRequest
     {
-        uint16_t bytes_to_align;
-        uint16_t pages;
+        std::size_t address;
+        void *data;
+        std::size_t size;
     };
 
-    /// @brief a
+    /// @brief Gathers several memory ranges in single transfer schedule
+    ///
+    /// @details
+    ///   Requests following each other in the same page are merged,
+    ///   if gap between them is small. Overlapping requests are allowed.
+    ///
+    /// @param[in] requests - ranges to read
+    ///
+    /// @returns size of readed data
+    std::size_t read(std::span<const ReadRequest> requests);
+
+    struct WriteRequest
+    {
+        std::size_t address;
+        const void *data;
+        std::size_t size;
+    };
+
+    /// @brief Scatters several buffers to memory in single transfer schedule
+    ///
+    /// @details
+    ///   Only requests which are directly adjacent within the same page are merged.
     ///
-    /// @param[in] address - base from which calculate pages information
-    /// @param[in] size - size of data to be transferred
+    /// @param[in] requests - ranges to write
     ///
-    /// @returns AddressInfo
-    static AddressInfo get_address_information(std::size_t address, std::size_t size);
+    /// @returns size of written bytes
+    std::size_t write(std::span<const WriteRequest> requests);
+
+    constexpr static std::size_t page_size = 1024;
+
+  private:
+    struct Copy
+    {
+        uint8_t *to;
+        const uint8_t *from;
+        std::size_t size;
+    };
+
+    /// @brief Calls chunk(address, offset, size) for each page crossed by range
+    template <typename Chunk>
+    static void split_pages(std::size_t address, std::size_t size, const Chunk &chunk);
+
+    void queue_read(std::size_t address, uint8_t *data, std::size_t size);
+    void queue_merged_read(std::span<const ReadRequest> requests, std::size_t address,
+                           std::size_t size);
+    void flush_reads();
+
+    void queue_write(std::size_t address, const uint8_t *data, std::size_t size);
+    void queue_merged_write(std::span<const WriteRequest> requests, std::size_t address,
+                            std::size_t size);
+    void flush_writes();
 
     QspiPSRAM &memory_;
+
+    QspiPSRAM::ReadRequest reads_[QspiPSRAM::max_burst_size];
+    QspiPSRAM::WriteRequest writes_[QspiPSRAM::max_burst_size];
+    std::size_t queued_;
+
+    Copy copies_[QspiPSRAM::max_burst_size * 4];
+    std::size_t copies_count_;
+    uint8_t staging_[page_size];
+    std::size_t staging_used_;
 };
 
 } // namespace msgpu::memory
@@ -0,0 +1,131 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace msgpu::memory
+{
+
+// Compressed framebuffer line is stored in slot starting with 16-bit little endian header.
+// Bit 15 of header marks RLE payload, bits 0-14 hold payload size.
+// RLE payload is sequence of (run length - 1, byte) pairs over packed line.
+// Lines which don't shrink are stored raw, so slot never exceeds line size + header.
+
+constexpr std::size_t line_header_size = 2;
+constexpr uint16_t rle_line_flag       = 0x8000;
+
+/// @returns size of slot needed for line of line_size bytes
+constexpr std::size_t encoded_line_capacity(std::size_t line_size)
+{
+    return line_header_size + line_size;
+}
+
+/// @returns number of payload bytes following header
+inline std::size_t encoded_payload_size(std::span<const uint8_t> slot)
+{
+    const uint16_t header = static_cast<uint16_t>(slot[0] | slot[1] << 8);
+    return header & ~rle_line_flag;
+}
+
+/// @brief Encodes bytes as RLE pairs
+///
+/// @returns encoded size, 0 if output is too small
+inline std::size_t rle_encode(std::span<const uint8_t> line, std::span<uint8_t> output)
+{
+    constexpr std::size_t max_run = 256;
+    std::size_t size              = 0;
+    for (std::size_t i = 0; i < line.size();)
+    {
+        std::size_t run = 1;
+        while (i + run < line.size() && run < max_run && line[i + run] == line[i])
+        {
+            ++run;
+        }
+
+        if (size + 2 > output.size())
+        {
+            return 0;
+        }
+        output[size++] = static_cast<uint8_t>(run - 1);
+        output[size++] = line[i];
+        i += run;
+    }
+    return size;
+}
+
+/// @brief Stores line in slot, compressed if it saves space
+///
+/// @param line - line in framebuffer pixel format
+/// @param slot - output, must hold encoded_line_capacity(line.size()) bytes
+///
+/// @returns number of used slot bytes, only those have to be written
+inline std::size_t encode_line(std::span<const uint8_t> line, std::span<uint8_t> slot)
+{
+    const std::span<uint8_t> payload = slot.subspan(line_header_size);
+    // RLE is used only when strictly smaller than raw line
+    std::size_t size = line.empty() ? 0 : rle_encode(line, payload.first(line.size() - 1));
+    uint16_t header  = static_cast<uint16_t>(size) | rle_line_flag;
+    if (size == 0)
+    {
+        size   = line.size();
+        header = static_cast<uint16_t>(size);
+        std::memcpy(payload.data(), line.data(), size);
+    }
+
+    slot[0] = static_cast<uint8_t>(header);
+    slot[1] = static_cast<uint8_t>(header >> 8);
+    return line_header_size + size;
+}
+
+/// @brief Restores line from slot
+///
+/// @param slot - header with payload, at least encoded_payload_size() bytes after header
+/// @param line - output line in framebuffer pixel format
+///
+/// @returns true if slot contained exactly one line
+inline bool decode_line(std::span<const uint8_t> slot, std::span<uint8_t> line)
+{
+    const uint16_t header                  = static_cast<uint16_t>(slot[0] | slot[1] << 8);
+    const std::span<const uint8_t> payload = slot.subspan(line_header_size, header & ~rle_line_flag);
+
+    if (!(header & rle_line_flag))
+    {
+        const std::size_t size = std::min(payload.size(), line.size());
+        std::memcpy(line.data(), payload.data(), size);
+        return size == line.size();
+    }
+
+    std::size_t position = 0;
+    for (std::size_t i = 0; i + 1 < payload.size(); i += 2)
+    {
+        const std::size_t run = static_cast<std::size_t>(payload[i]) + 1;
+        if (position + run > line.size())
+        {
+            return false;
+        }
+        std::fill_n(line.begin() + static_cast<std::ptrdiff_t>(position), run, payload[i + 1]);
+        position += run;
+    }
+    return position == line.size();
+}
+
+} // namespace msgpu::memory
@@ -0,0 +1,117 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace msgpu::memory
+{
+
+/// @brief Framebuffer pixel formats negotiated between GPU and RAMDAC
+///
+/// @details
+///   Value is number of bits used by pixel in framebuffer.
+///   Wide format keeps one pixel per 16-bit word, packed formats store
+///   pixels tightly, first pixel of byte in low nibble for 4-bit format.
+enum class PixelFormat : uint8_t
+{
+    Packed4 = 4,
+    Packed8 = 8,
+    Wide16  = 16,
+};
+
+/// @returns smallest framebuffer format which holds colour depth of mode
+constexpr PixelFormat select_pixel_format(std::size_t bits_per_pixel)
+{
+    if (bits_per_pixel <= 4)
+    {
+        return PixelFormat::Packed4;
+    }
+    if (bits_per_pixel <= 8)
+    {
+        return PixelFormat::Packed8;
+    }
+    return PixelFormat::Wide16;
+}
+
+/// @returns number of bytes needed for line of width pixels
+constexpr std::size_t packed_line_size(std::size_t width, PixelFormat format)
+{
+    return (width * static_cast<std::size_t>(format) + 7) / 8;
+}
+
+/// @brief Converts line buffer pixels to framebuffer format
+///
+/// @param pixels - pixels, one per element
+/// @param format - framebuffer format
+/// @param output - packed line, must hold packed_line_size() bytes
+inline void pack_line(std::span<const uint16_t> pixels, PixelFormat format,
+                      std::span<uint8_t> output)
+{
+    switch (format)
+    {
+    case PixelFormat::Packed4:
+        for (std::size_t x = 0; x + 1 < pixels.size(); x += 2)
+        {
+            output[x / 2] = static_cast<uint8_t>((pixels[x] & 0x0f) | (pixels[x + 1] & 0x0f) << 4);
+        }
+        if (pixels.size() % 2)
+        {
+            output[pixels.size() / 2] = static_cast<uint8_t>(pixels.back() & 0x0f);
+        }
+        break;
+    case PixelFormat::Packed8:
+        std::transform(pixels.begin(), pixels.end(), output.begin(),
+                       [](uint16_t pixel) { return static_cast<uint8_t>(pixel); });
+        break;
+    case PixelFormat::Wide16:
+        std::memcpy(output.data(), pixels.data(), pixels.size_bytes());
+        break;
+    }
+}
+
+/// @brief Converts framebuffer line to pixels, one per element
+///
+/// @param packed - line in framebuffer format
+/// @param format - framebuffer format
+/// @param pixels - output pixels
+inline void unpack_line(std::span<const uint8_t> packed, PixelFormat format,
+                        std::span<uint16_t> pixels)
+{
+    switch (format)
+    {
+    case PixelFormat::Packed4:
+        for (std::size_t x = 0; x < pixels.size(); ++x)
+        {
+            pixels[x] = static_cast<uint16_t>((packed[x / 2] >> ((x % 2) * 4)) & 0x0f);
+        }
+        break;
+    case PixelFormat::Packed8:
+        std::copy(packed.begin(), packed.begin() + static_cast<std::ptrdiff_t>(pixels.size()),
+                  pixels.begin());
+        break;
+    case PixelFormat::Wide16:
+        std::memcpy(pixels.data(), packed.data(), pixels.size_bytes());
+        break;
+    }
+}
+
+} // namespace msgpu::memory
@@ -35,7 +35,39 @@ public:
     using DataBuffer = std::span<uint8_t>;
     using ConstDataBuffer = std::span<const uint8_t>;
     std::size_t write(std::size_t address, const ConstDataBuffer data);
+
+    struct WriteRequest
+    {
+        std::size_t address;
+        ConstDataBuffer data;
+    };
+
+    constexpr static std::size_t max_burst_size = 8;
+
+    /// @brief Writes up to max_burst_size blocks with single bus acquisition
+    ///
+    /// @details
+    ///   Transactions are sent back to back by one DMA chain, see Qspi::qspi_command_write.
+    ///   Last one is finished by wait_for_finish().
+    ///
+    /// @returns number of written bytes
+    std::size_t write(std::span<const WriteRequest> requests);
     std::size_t read(const std::size_t address, DataBuffer data);
+
+    struct ReadRequest
+    {
+        std::size_t address;
+        DataBuffer data;
+    };
+
+    /// @brief Reads up to max_burst_size blocks with single bus acquisition
+    ///
+    /// @details
+    ///   Each read is started when previous one is finished, bus is kept between them.
+    ///   Last one is finished by wait_for_finish().
+    ///
+    /// @returns number of read bytes
+    std::size_t read(std::span<const ReadRequest> requests);
     void wait_for_finish() const;
 
     bool test();
@@ -43,6 +75,9 @@ public:
 
     void acquire_bus();
     void release_bus();
+
+    /// @brief Releases bus as soon as started transfer is finished, without waiting for it
+    void release_bus_on_finish();
 private:
     bool perform_post();
     void enter_qpi_mode();
@@ -50,6 +85,9 @@ private:
    
     Qspi& qspi_;
     bool qspi_mode_;
+    // DMA may still send commands after write returns, so they can't live on stack
+    uint8_t write_commands_[max_burst_size][4];
+    uint8_t read_commands_[max_burst_size][5];
 };
 
 } // namespace msgpu::memory
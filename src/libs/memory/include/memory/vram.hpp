@@ -21,6 +21,8 @@
 
 #include "sync.hpp"
 
+#include "memory/line_codec.hpp"
+#include "memory/pixel_format.hpp"
 #include "memory/psram.hpp"
 
 namespace msgpu::memory 
@@ -38,7 +40,29 @@ public:
     VideoRam(memory::QspiPSRAM& memory);
 
     void set_resolution(uint16_t width, uint16_t height);
+
+    /// @brief Selects framebuffer format for colour depth
+    ///
+    /// @details
+    ///   Lines are stored in smallest format which holds colour depth.
+    ///   Packed formats use tight line stride, 16-bit format keeps line per page.
+    ///   Lines written as uint16_t are one pixel per element and are converted,
+    ///   lines written as uint8_t must be already in framebuffer format.
     void set_color_space(uint8_t bits_per_pixel);
+    PixelFormat get_pixel_format() const;
+
+    /// @returns number of bytes in line stored in framebuffer format
+    std::size_t get_line_size() const;
+
+    /// @brief Enables compressed line format
+    ///
+    /// @details
+    ///   Each line is stored in slot starting with header, see line_codec.hpp.
+    ///   Lines are RLE encoded when it makes them smaller. Line equal to one
+    ///   written previously to the same slot is not transferred at all.
+    ///   Both GPU and RAMDAC must use the same setting.
+    void set_compression(bool enabled);
+    bool get_compression() const;
 
     void write_line(uint16_t line, const ConstDataType<uint16_t>& data);
     void write_line(uint16_t line, const ConstDataType<uint8_t>& data);
@@ -46,12 +70,34 @@ public:
     void read_line(uint16_t line, DataType<uint16_t> data);
     void read_line(uint16_t line, DataType<uint8_t> data);
 
+    constexpr static std::size_t max_lines_per_write = QspiPSRAM::max_burst_size;
+
+    /// @brief Starts write of consecutive lines without waiting until transfer is finished
+    ///
+    /// @details
+    ///   Lines are sent as one burst, bus is acquired once for all of them
+    ///   and released from DMA interrupt as soon as burst is sent.
+    ///   Data must stay untouched until transfer is finished.
+    ///   Transfer is awaited lazily, when next transfer is started
+    ///   or wait_for_write() is called, so caller may prepare next lines meanwhile.
+    ///   When compression is enabled, lines must be already encoded with encode_line(),
+    ///   only used bytes of slot should be passed.
+    ///
+    /// @param first_line - number of first line
+    /// @param lines - line data, up to max_lines_per_write lines
+    void write_lines_async(uint16_t first_line, std::span<const ConstDataType<uint8_t>> lines);
+
+    /// @brief Waits until asynchronous write is finished and bus is released
+    void wait_for_write();
+
     void write_line(uint8_t buffer_id, uint16_t line, const ConstDataType<uint16_t>& data);
     void write_line(uint8_t buffer_id, uint16_t line, const ConstDataType<uint8_t>& data);
 
     void read_line(uint8_t buffer_id, uint16_t line, DataType<uint16_t> data);
     void read_line(uint8_t buffer_id, uint16_t line, DataType<uint8_t> data);
 
+    /// @brief Copies line between buffers without conversion to pixels
+    void copy_line(uint8_t from_buffer_id, uint8_t to_buffer_id, uint16_t line);
 
     void select_buffer(uint8_t read_buffer_id, uint8_t write_buffer_id);
     uint8_t get_read_buffer_id();
@@ -60,13 +106,28 @@ public:
     void block();
     void unblock();
 private:
+    constexpr static std::size_t max_buffers = 2;
+    constexpr static std::size_t max_height = 480;
+
     std::size_t get_address(uint8_t buffer_id, uint16_t line) const;
-    
-    uint8_t bits_per_pixel_;
+    std::size_t get_line_stride() const;
+    std::size_t max_pixels_in_line() const;
+    void write(std::size_t address, const ConstDataType<uint8_t>& data);
+    void read(std::size_t address, DataType<uint8_t> data);
+    void write_packed_line(uint8_t buffer_id, uint16_t line, const ConstDataType<uint8_t>& data);
+    void read_packed_line(uint8_t buffer_id, uint16_t line, DataType<uint8_t> data);
+    bool is_line_unchanged(uint8_t buffer_id, uint16_t line, const ConstDataType<uint8_t>& slot);
+    void invalidate_lines();
+
+    PixelFormat format_;
+    bool compression_;
+    // hashes of slots stored in framebuffer, 0 when content is unknown
+    uint32_t line_hashes_[max_buffers][max_height];
     uint8_t read_buffer_id_;
     uint8_t write_buffer_id_;
     uint16_t width_;
     uint16_t height_;
+    bool write_pending_;
     mutex_t mutex_;
     memory::QspiPSRAM& memory_;
 };
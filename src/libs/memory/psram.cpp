@@ -16,6 +16,7 @@
 
 #include "memory/psram.hpp"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
@@ -99,34 +100,69 @@ void __time_critical_func(QspiPSRAM::wait_for_finish)() const
 
 std::size_t __time_critical_func(QspiPSRAM::write)(std::size_t address, const ConstDataBuffer data)
 {
-    const uint8_t cmd[] = {
-        qspi_write_cmd, 
-        static_cast<uint8_t>((address >> 16)), 
-        static_cast<uint8_t>((address >> 8)), 
-        static_cast<uint8_t>(address & 0xff)
-    };
+    const WriteRequest request{address, data};
+    return write(std::span<const WriteRequest>(&request, 1));
+}
+
+std::size_t __time_critical_func(QspiPSRAM::write)(std::span<const WriteRequest> requests)
+{
+    const std::size_t count = std::min(requests.size(), max_burst_size);
+    Qspi::CommandWrite transfers[max_burst_size];
+    std::size_t written = 0;
 
+    // previous transfers may still use commands, they are awaited here
     qspi_.acquire_bus();
-    qspi_.qspi_command_write(cmd, data);
-    return data.size();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const std::size_t address = requests[i].address;
+        auto& cmd = write_commands_[i];
+        cmd[0] = qspi_write_cmd;
+        cmd[1] = static_cast<uint8_t>((address >> 16));
+        cmd[2] = static_cast<uint8_t>((address >> 8));
+        cmd[3] = static_cast<uint8_t>(address & 0xff);
+
+        transfers[i] = Qspi::CommandWrite{cmd, requests[i].data};
+        written += requests[i].data.size();
+    }
+
+    qspi_.qspi_command_write(std::span<const Qspi::CommandWrite>(transfers, count));
+    return written;
 }
 
 std::size_t __time_critical_func(QspiPSRAM::read)(const std::size_t address, DataBuffer data)
 {
-    constexpr uint8_t wait_cycles = 6;
+    const ReadRequest request{address, data};
+    return read(std::span<const ReadRequest>(&request, 1));
+}
 
-    // Wait cycles must be patched, so it cannot be const
-    uint8_t cmd[] = {
-        qspi_fast_read_cmd, 
-        static_cast<uint8_t>((address >> 16)), 
-        static_cast<uint8_t>((address >> 8)), 
-        static_cast<uint8_t>((address & 0xff)),
-        wait_cycles 
-    };
+std::size_t __time_critical_func(QspiPSRAM::read)(std::span<const ReadRequest> requests)
+{
+    constexpr uint8_t wait_cycles = 6;
+    const std::size_t count = std::min(requests.size(), max_burst_size);
+    std::size_t read_bytes = 0;
 
     qspi_.acquire_bus();
-    qspi_.qspi_command_read(cmd, data);
-    return data.size();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        if (i != 0)
+        {
+            // DMA channels are shared by transactions, previous one must be drained
+            qspi_.wait_for_finish();
+        }
+
+        // Wait cycles are patched by Qspi, so command is filled for each read
+        const std::size_t address = requests[i].address;
+        auto& cmd = read_commands_[i];
+        cmd[0] = qspi_fast_read_cmd;
+        cmd[1] = static_cast<uint8_t>((address >> 16));
+        cmd[2] = static_cast<uint8_t>((address >> 8));
+        cmd[3] = static_cast<uint8_t>(address & 0xff);
+        cmd[4] = wait_cycles;
+
+        qspi_.qspi_command_read(cmd, requests[i].data);
+        read_bytes += requests[i].data.size();
+    }
+    return read_bytes;
 }
 
 bool QspiPSRAM::perform_post()
@@ -310,4 +346,9 @@ void QspiPSRAM::release_bus()
     qspi_.release_bus();
 }
 
+void QspiPSRAM::release_bus_on_finish()
+{
+    qspi_.release_bus_on_finish();
+}
+
 } // namespace msgpu::memory
@@ -16,6 +16,7 @@
 
 #include "memory/vram.hpp"
 
+#include <algorithm>
 #include <cstdio>
 
 namespace msgpu::memory 
@@ -26,14 +27,57 @@ namespace
 
 constexpr std::size_t page_size = 1024;
 
+// compressed line slot holds at most header and raw line
+constexpr std::size_t max_slot_size = encoded_line_capacity(page_size);
+
+// flat lines fit in first read, rest of slot is read only when needed
+constexpr std::size_t first_slot_read = 64;
+
+// PSRAM burst wraps at page end, so transfers crossing page are split
+std::size_t bytes_in_page(std::size_t address, std::size_t size)
+{
+    return std::min(size, page_size - address % page_size);
+}
+
+std::size_t split_pages(std::size_t address, std::span<const uint8_t> data,
+    std::span<QspiPSRAM::WriteRequest> requests)
+{
+    std::size_t count = 0;
+    while (!data.empty() && count < requests.size())
+    {
+        const std::size_t part = bytes_in_page(address, data.size());
+        requests[count++] = QspiPSRAM::WriteRequest{address, data.first(part)};
+        address += part;
+        data = data.subspan(part);
+    }
+    return count;
+}
+
+// FNV-1a, 0 is reserved for unknown line
+uint32_t hash_slot(std::span<const uint8_t> slot)
+{
+    uint32_t hash = 2166136261u;
+    for (const uint8_t byte : slot)
+    {
+        hash = (hash ^ byte) * 16777619u;
+    }
+    return hash ? hash : 1;
+}
+
 } // namespace 
 
 VideoRam::VideoRam(memory::QspiPSRAM& memory)
-    : read_buffer_id_(0)
+    : format_(PixelFormat::Wide16)
+    , compression_(false)
+    , read_buffer_id_(0)
     , write_buffer_id_(1)
+    , width_(320)
+    , height_(240)
+    , write_pending_(false)
     , memory_(memory)
 {
     mutex_init(&mutex_);
+    invalidate_lines();
 }
 
 void VideoRam::set_resolution(uint16_t width, uint16_t height)
@@ -41,64 +85,203 @@ void VideoRam::set_resolution(uint16_t width, uint16_t height)
     block();
     width_ = width;
     height_ = height;
+    invalidate_lines();
     unblock();
 }
 
 void VideoRam::set_color_space(uint8_t bits_per_pixel)
 {
     block();
-    bits_per_pixel_ = bits_per_pixel;
+    format_ = select_pixel_format(bits_per_pixel);
+    invalidate_lines();
     unblock();
 }
 
-std::size_t VideoRam::get_address(uint8_t buffer_id, uint16_t line) const 
+void VideoRam::set_compression(bool enabled)
 {
-    return page_size * line + page_size * height_ * buffer_id;
+    block();
+    compression_ = enabled;
+    invalidate_lines();
+    unblock();
 }
 
-void VideoRam::write_line(uint8_t buffer_id, uint16_t line, const ConstDataType<uint16_t> &data)
+bool VideoRam::get_compression() const
 {
-    const std::size_t address = get_address(buffer_id, line);
+    return compression_;
+}
 
-    // TODO: add compression 
-    const ConstDataType<uint8_t> buffer(reinterpret_cast<const uint8_t*>(data.data()), data.size() * 2);
+PixelFormat VideoRam::get_pixel_format() const
+{
+    return format_;
+}
+
+std::size_t VideoRam::get_line_size() const
+{
+    return packed_line_size(width_, format_);
+}
+
+std::size_t VideoRam::max_pixels_in_line() const
+{
+    return page_size * 8 / static_cast<std::size_t>(format_);
+}
+
+std::size_t VideoRam::get_line_stride() const
+{
+    const std::size_t line_size = get_line_size();
+    const std::size_t slot_size = compression_ ? encoded_line_capacity(line_size) : line_size;
+    if (format_ == PixelFormat::Wide16)
+    {
+        return (slot_size + page_size - 1) / page_size * page_size;
+    }
+    return slot_size;
+}
+
+std::size_t VideoRam::get_address(uint8_t buffer_id, uint16_t line) const 
+{
+    const std::size_t stride = get_line_stride();
+    return stride * line + stride * height_ * buffer_id;
+}
+
+void VideoRam::write(std::size_t address, const ConstDataType<uint8_t> &data)
+{
+    // slot with header may touch 3 pages
+    QspiPSRAM::WriteRequest requests[3];
+    const std::size_t count = split_pages(address, data, requests);
 
     memory_.acquire_bus();
-    memory_.write(address, buffer); 
+    memory_.write(std::span<const QspiPSRAM::WriteRequest>(requests, count));
     memory_.wait_for_finish();
     memory_.release_bus();
 }
 
-void VideoRam::write_line(uint8_t buffer_id, uint16_t line, const ConstDataType<uint8_t> &data)
+void VideoRam::read(std::size_t address, DataType<uint8_t> data)
 {
-    const std::size_t address = get_address(buffer_id, line);
-
     memory_.acquire_bus();
-    memory_.write(address, data);
-    // TODO: in future move at beginning of functions to be 'async'
-    memory_.wait_for_finish();
+    while (!data.empty())
+    {
+        const std::size_t part = bytes_in_page(address, data.size());
+        memory_.read(address, data.first(part));
+        memory_.wait_for_finish();
+        address += part;
+        data = data.subspan(part);
+    }
     memory_.release_bus();
 }
 
+void VideoRam::invalidate_lines()
+{
+    for (auto& hashes : line_hashes_)
+    {
+        std::fill(std::begin(hashes), std::end(hashes), 0u);
+    }
+}
+
+bool VideoRam::is_line_unchanged(uint8_t buffer_id, uint16_t line,
+    const ConstDataType<uint8_t>& slot)
+{
+    if (buffer_id >= max_buffers || line >= max_height)
+    {
+        return false;
+    }
+
+    const uint32_t hash = hash_slot(slot);
+    if (line_hashes_[buffer_id][line] == hash)
+    {
+        return true;
+    }
+    line_hashes_[buffer_id][line] = hash;
+    return false;
+}
+
+void VideoRam::write_packed_line(uint8_t buffer_id, uint16_t line,
+    const ConstDataType<uint8_t>& data)
+{
+    if (!compression_)
+    {
+        write(get_address(buffer_id, line), data);
+        return;
+    }
+
+    uint8_t slot[max_slot_size];
+    const std::size_t size = encode_line(data.first(std::min(data.size(), page_size)), slot);
+    const ConstDataType<uint8_t> encoded(slot, size);
+    if (is_line_unchanged(buffer_id, line, encoded))
+    {
+        return;
+    }
+    write(get_address(buffer_id, line), encoded);
+}
+
+void VideoRam::read_packed_line(uint8_t buffer_id, uint16_t line, DataType<uint8_t> data)
+{
+    if (!compression_)
+    {
+        read(get_address(buffer_id, line), data);
+        return;
+    }
+
+    uint8_t slot[max_slot_size];
+    const std::size_t address = get_address(buffer_id, line);
+    const std::size_t capacity = encoded_line_capacity(std::min(data.size(), page_size));
+    const std::size_t first_part = std::min(capacity, first_slot_read);
+    read(address, DataType<uint8_t>(slot, first_part));
+
+    const std::size_t size = line_header_size + encoded_payload_size(slot);
+    if (size > capacity)
+    {
+        // slot was never written in current format
+        std::fill(data.begin(), data.end(), 0);
+        return;
+    }
+
+    if (size > first_part)
+    {
+        read(address + first_part, DataType<uint8_t>(slot + first_part, size - first_part));
+    }
+    decode_line(ConstDataType<uint8_t>(slot, size), data);
+}
+
+void VideoRam::write_line(uint8_t buffer_id, uint16_t line, const ConstDataType<uint16_t> &data)
+{
+    wait_for_write();
+    uint8_t packed[page_size];
+    const std::size_t pixels = std::min(data.size(), max_pixels_in_line());
+    pack_line(data.first(pixels), format_, packed);
+
+    const ConstDataType<uint8_t> packed_line(packed, packed_line_size(pixels, format_));
+    write_packed_line(buffer_id, line, packed_line);
+}
+
+void VideoRam::write_line(uint8_t buffer_id, uint16_t line, const ConstDataType<uint8_t> &data)
+{
+    wait_for_write();
+    write_packed_line(buffer_id, line, data);
+}
+
 void VideoRam::read_line(uint8_t buffer_id, uint16_t line, DataType<uint16_t> data)
 {
-    const std::size_t address = get_address(buffer_id, line); 
-    const DataType<uint8_t> buffer(reinterpret_cast<uint8_t*>(data.data()), data.size() * 2);
+    wait_for_write();
+    uint8_t packed[page_size];
+    const std::size_t pixels = std::min(data.size(), max_pixels_in_line());
+    const std::size_t size = packed_line_size(pixels, format_);
+    read_packed_line(buffer_id, line, DataType<uint8_t>(packed, size));
 
-    memory_.acquire_bus();
-    memory_.read(address, buffer); 
-    memory_.wait_for_finish();
-    memory_.release_bus();
+    unpack_line(ConstDataType<uint8_t>(packed, size), format_, data.first(pixels));
 }
 
 void VideoRam::read_line(uint8_t buffer_id, uint16_t line, DataType<uint8_t> data)
 {
-    const std::size_t address = get_address(buffer_id, line); 
+    wait_for_write();
+    read_packed_line(buffer_id, line, data);
+}
 
-    memory_.acquire_bus();
-    memory_.read(address, data);
-    memory_.wait_for_finish();
-    memory_.release_bus();
+void VideoRam::copy_line(uint8_t from_buffer_id, uint8_t to_buffer_id, uint16_t line)
+{
+    wait_for_write();
+    uint8_t packed[page_size];
+    const DataType<uint8_t> packed_line(packed, std::min(get_line_size(), page_size));
+    read_packed_line(from_buffer_id, line, packed_line);
+    write_packed_line(to_buffer_id, line, packed_line);
 }
 
 void VideoRam::write_line(uint16_t line, const ConstDataType<uint16_t> &data)
@@ -133,6 +316,57 @@ void VideoRam::read_line(uint16_t line, DataType<uint8_t> data)
     mutex_exit(&mutex_);
 }
 
+void VideoRam::write_lines_async(uint16_t first_line,
+    std::span<const ConstDataType<uint8_t>> lines)
+{
+    // each line may cross page boundary, slot with header may touch 3 pages
+    QspiPSRAM::WriteRequest requests[3 * max_lines_per_write];
+    std::size_t count = 0;
+
+    mutex_enter_blocking(&mutex_);
+    for (std::size_t i = 0; i < std::min(lines.size(), max_lines_per_write); ++i)
+    {
+        const uint16_t line = static_cast<uint16_t>(first_line + i);
+        if (compression_ && is_line_unchanged(write_buffer_id_, line, lines[i]))
+        {
+            continue;
+        }
+        const std::size_t address = get_address(write_buffer_id_, line);
+        count += split_pages(address, lines[i],
+            std::span<QspiPSRAM::WriteRequest>(requests).subspan(count));
+    }
+
+    // previous burst is finished only now, rendering of current lines overlapped with it
+    wait_for_write();
+    if (count == 0)
+    {
+        mutex_exit(&mutex_);
+        return;
+    }
+    for (std::size_t i = 0; i < count; i += QspiPSRAM::max_burst_size)
+    {
+        // next burst waits in acquire_bus until previous one is sent
+        memory_.acquire_bus();
+        memory_.write(std::span<const QspiPSRAM::WriteRequest>(&requests[i],
+            std::min(QspiPSRAM::max_burst_size, count - i)));
+    }
+    // RAMDAC may scan out as soon as burst is sent, bus is not kept until next write
+    memory_.release_bus_on_finish();
+    write_pending_ = true;
+    mutex_exit(&mutex_);
+}
+
+void VideoRam::wait_for_write()
+{
+    if (!write_pending_)
+    {
+        return;
+    }
+
+    memory_.wait_for_finish();
+    memory_.release_bus();
+    write_pending_ = false;
+}
 
 void VideoRam::select_buffer(uint8_t read_buffer_id, uint8_t write_buffer_id)
 {
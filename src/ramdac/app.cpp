@@ -99,6 +99,16 @@ void App::run()
                 // msgpu::enable_dump();
                 framebuffer_.select_buffer(rx_buf[1], rx_buf[1]);
 
+                uint8_t ack[2] = {0xac, 0x88};
+                i2c_.write(ack);
+            } break;
+            case 0x04:
+            {
+                printf ("Framebuffer format: %d bits per pixel, compression: %d\n", rx_buf[1],
+                    rx_buf[2]);
+                framebuffer_.set_color_space(rx_buf[1]);
+                framebuffer_.set_compression(rx_buf[2] != 0);
+
                 uint8_t ack[2] = {0xac, 0x88};
                 i2c_.write(ack);
             }
@@ -0,0 +1,139 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <span>
+
+#include "ips6404/ips6404.hpp"
+#include "qspi_bus.hpp"
+
+#include "arch/qspi_config.hpp"
+#include "qspi.hpp"
+
+#include "io/usart_point.hpp"
+#include "memory/gpuram.hpp"
+#include "memory/psram.hpp"
+#include "memory/vram.hpp"
+
+namespace msgpu::benchmark
+{
+
+/// @brief I2C replacement, RAMDAC is not attached during benchmarks, all commands are accepted
+struct NullI2C
+{
+    void read(std::span<uint8_t> data)
+    {
+        constexpr uint8_t ack[] = {0xac, 0x88};
+        std::copy_n(ack, std::min(data.size(), sizeof(ack)), data.begin());
+    }
+
+    void write(uint8_t address, std::span<const uint8_t> data)
+    {
+        static_cast<void>(address);
+        static_cast<void>(data);
+    }
+};
+
+/// @brief Hardware stack used by GPU modes, backed by IPS6404 stubs
+///
+/// @details
+///   IPS6404 stubs emulate transfer time of real PSRAM, so results include
+///   time spent on QSPI transactions, not only CPU work.
+class Environment
+{
+  public:
+    Environment()
+        : qspi_(framebuffer_config, 3.0f)
+        , qspi_ram_(gpuram_config, 3.0f)
+        , qspi_memory_(qspi_, true)
+        , qspi_gpuram_(qspi_ram_, true)
+        , framebuffer_(qspi_memory_)
+        , gpuram_(qspi_gpuram_)
+    {
+        auto framebuffer_device =
+            std::make_unique<stubs::IPS6404Stub>("msgpu_benchmark_framebuffer");
+        framebuffer_device_ = framebuffer_device.get();
+        QspiBus::get().register_device(static_cast<int>(framebuffer_config.io_base),
+                                       std::move(framebuffer_device));
+        QspiBus::get().register_device(
+            static_cast<int>(gpuram_config.io_base),
+            std::make_unique<stubs::IPS6404Stub>("msgpu_benchmark_gpuram"));
+    }
+
+    memory::VideoRam &framebuffer()
+    {
+        return framebuffer_;
+    }
+
+    /// @brief Stub behind framebuffer, owned by QspiBus
+    stubs::IPS6404Stub &framebuffer_device()
+    {
+        return *framebuffer_device_;
+    }
+
+    memory::GpuRAM &gpuram()
+    {
+        return gpuram_;
+    }
+
+    NullI2C &i2c()
+    {
+        return i2c_;
+    }
+
+    io::UsartPoint &usart()
+    {
+        return usart_;
+    }
+
+  private:
+    Qspi qspi_;
+    Qspi qspi_ram_;
+    memory::QspiPSRAM qspi_memory_;
+    memory::QspiPSRAM qspi_gpuram_;
+    memory::VideoRam framebuffer_;
+    memory::GpuRAM gpuram_;
+    NullI2C i2c_;
+    io::UsartPoint usart_;
+    stubs::IPS6404Stub *framebuffer_device_;
+};
+
+/// @brief Measures average execution time of function in microseconds
+///
+/// @param iterations - how many times function is executed
+/// @param prepare - called before each measured execution, not measured
+/// @param measured - measured function
+template <typename Prepare, typename Measured>
+double measure_us(int iterations, Prepare &&prepare, Measured &&measured)
+{
+    std::chrono::nanoseconds total{0};
+    for (int i = 0; i < iterations; ++i)
+    {
+        prepare();
+        const auto start = std::chrono::steady_clock::now();
+        measured();
+        total += std::chrono::steady_clock::now() - start;
+    }
+    return static_cast<double>(total.count()) / 1000.0 / iterations;
+}
+
+} // namespace msgpu::benchmark
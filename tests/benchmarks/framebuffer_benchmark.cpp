@@ -0,0 +1,164 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "mode/2d_graphic_mode.hpp"
+
+#include "benchmark.hpp"
+
+namespace msgpu::benchmark
+{
+
+struct Configuration
+{
+    constexpr static std::size_t resolution_width  = 320;
+    constexpr static std::size_t resolution_height = 240;
+    constexpr static std::size_t bits_per_pixel    = 8;
+};
+
+struct CompressedConfiguration : Configuration
+{
+    constexpr static bool compressed_framebuffer = true;
+};
+
+using RawMode        = mode::GraphicMode2D<Configuration, NullI2C>;
+using CompressedMode = mode::GraphicMode2D<CompressedConfiguration, NullI2C>;
+
+template <typename Mode>
+void add_rectangle(Mode &mode, uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1,
+                   uint16_t color)
+{
+    mode.add_triangle(mode::Triangle{
+        .color = color,
+        .v     = {{.x = x0, .y = y0}, {.x = x1, .y = y0}, {.x = x1, .y = y1}},
+    });
+    mode.add_triangle(mode::Triangle{
+        .color = color,
+        .v     = {{.x = x0, .y = y0}, {.x = x1, .y = y1}, {.x = x0, .y = y1}},
+    });
+}
+
+/// @brief Flat colour windows and buttons, typical user interface frame
+template <typename Mode>
+void submit_ui_scene(Mode &mode, int frame)
+{
+    static_cast<void>(frame);
+    add_rectangle(mode, 0, 0, 319, 239, 0x12);
+    add_rectangle(mode, 0, 0, 319, 15, 0x34);
+    add_rectangle(mode, 20, 30, 299, 219, 0xf0);
+    for (uint16_t i = 0; i < 4; ++i)
+    {
+        const auto x = static_cast<uint16_t>(40 + i * 64);
+        add_rectangle(mode, x, 180, static_cast<uint16_t>(x + 48), 200, 0x56);
+    }
+}
+
+/// @brief User interface with small indicator moving every frame
+template <typename Mode>
+void submit_hud_scene(Mode &mode, int frame)
+{
+    submit_ui_scene(mode, frame);
+    const auto x = static_cast<uint16_t>(40 + frame % 200);
+    add_rectangle(mode, x, 100, static_cast<uint16_t>(x + 8), 108, 0xff);
+}
+
+/// @brief Many small triangles with random colours, worst case for compression
+template <typename Mode>
+void submit_noise_scene(Mode &mode, int frame)
+{
+    srand(static_cast<unsigned>(1234 + frame));
+    for (std::size_t i = 0; i < 2048; ++i)
+    {
+        const auto x = static_cast<uint16_t>(rand() % (Configuration::resolution_width - 8));
+        const auto y = static_cast<uint16_t>(rand() % (Configuration::resolution_height - 8));
+        mode.add_triangle(mode::Triangle{
+            .color = static_cast<uint16_t>(rand() & 0xff),
+            .v     = {{.x = x, .y = y},
+                      {.x = static_cast<uint16_t>(x + 8), .y = y},
+                      {.x = x, .y = static_cast<uint16_t>(y + 8)}},
+        });
+    }
+}
+
+/// @brief Renders frame with buffers swapped like after SwapBuffer
+///
+/// @returns bytes sent to framebuffer during frame
+template <typename Mode, typename Scene>
+std::size_t render_frame(Environment &env, Mode &mode, Scene &&scene, int frame)
+{
+    mode.clear();
+    scene(mode, frame);
+
+    env.framebuffer_device().reset_statistics();
+    mode.render();
+    env.framebuffer().wait_for_write();
+    const auto &statistics = env.framebuffer_device().statistics();
+
+    const uint8_t written = env.framebuffer().get_write_buffer_id();
+    env.framebuffer().select_buffer(written, written ? 0 : 1);
+    return statistics.bytes_written + statistics.bytes_read;
+}
+
+template <typename Mode, typename Scene>
+void run_scene(Environment &env, const char *name, const char *scene_name, Scene &&scene)
+{
+    // Mode is too big for stack
+    auto mode = std::make_unique<Mode>(env.framebuffer(), env.gpuram(), env.i2c(), env.usart());
+
+    constexpr int frames = 10;
+    int frame            = 0;
+
+    // first frames fill both buffers, next ones are rendered over previous content
+    const std::size_t first_frame = render_frame(env, *mode, scene, frame++);
+    render_frame(env, *mode, scene, frame++);
+
+    std::size_t bytes        = 0;
+    const double render_time = measure_us(
+        frames, [] {}, [&] { bytes += render_frame(env, *mode, scene, frame++); });
+
+    printf("%12s | %6s | %18zu | %18zu | %16.1f\n", name, scene_name, first_frame,
+           bytes / frames, render_time);
+}
+
+template <typename Mode>
+void run(Environment &env, const char *name)
+{
+    run_scene<Mode>(env, name, "ui", [](Mode &mode, int frame) { submit_ui_scene(mode, frame); });
+    run_scene<Mode>(env, name, "hud",
+                    [](Mode &mode, int frame) { submit_hud_scene(mode, frame); });
+    run_scene<Mode>(env, name, "noise",
+                    [](Mode &mode, int frame) { submit_noise_scene(mode, frame); });
+}
+
+} // namespace msgpu::benchmark
+
+int main()
+{
+    using namespace msgpu::benchmark;
+
+    static Environment env;
+
+    printf("Framebuffer benchmark: %zux%zu, %zu bits per pixel\n", Configuration::resolution_width,
+           Configuration::resolution_height, Configuration::bits_per_pixel);
+    printf("%12s | %6s | %18s | %18s | %16s\n", "format", "scene", "first [B/frame]",
+           "next [B/frame]", "render [us/frame]");
+    run<RawMode>(env, "raw");
+    run<CompressedMode>(env, "compressed");
+    return 0;
+}
@@ -0,0 +1,127 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "mode/2d_graphic_mode.hpp"
+
+#include "benchmark.hpp"
+
+namespace msgpu::benchmark
+{
+
+struct Configuration
+{
+    constexpr static std::size_t resolution_width  = 320;
+    constexpr static std::size_t resolution_height = 240;
+    constexpr static std::size_t bits_per_pixel    = 8;
+};
+
+struct FixedPointConfiguration : Configuration
+{
+    constexpr static bool fixed_point_edges = true;
+};
+
+using FloatMode      = mode::GraphicMode2D<Configuration, NullI2C>;
+using FixedPointMode = mode::GraphicMode2D<FixedPointConfiguration, NullI2C>;
+
+mode::vertex_2d random_vertex(uint16_t x, uint16_t y, uint16_t spread)
+{
+    const auto offset = [spread](uint16_t base, std::size_t limit) {
+        const int value = base + rand() % (2 * spread + 1) - spread;
+        return static_cast<uint16_t>(std::clamp(value, 0, static_cast<int>(limit) - 1));
+    };
+    return mode::vertex_2d{
+        .x = offset(x, Configuration::resolution_width),
+        .y = offset(y, Configuration::resolution_height),
+    };
+}
+
+/// @brief Scene with small triangles spread uniformly over whole screen
+template <typename Mode>
+void submit_scene(Mode &mode, std::size_t triangles, uint16_t triangle_size)
+{
+    srand(1234);
+    for (std::size_t i = 0; i < triangles; ++i)
+    {
+        const auto x = static_cast<uint16_t>(rand() % Configuration::resolution_width);
+        const auto y = static_cast<uint16_t>(rand() % Configuration::resolution_height);
+        mode.add_triangle(mode::Triangle{
+            .color = static_cast<uint16_t>(rand() & 0xff),
+            .v =
+                {
+                    random_vertex(x, y, triangle_size),
+                    random_vertex(x, y, triangle_size),
+                    random_vertex(x, y, triangle_size),
+                },
+        });
+    }
+}
+
+template <typename Mode>
+void run(Environment &env, const char *name)
+{
+    // Mode is too big for stack
+    auto mode = std::make_unique<Mode>(env.framebuffer(), env.gpuram(), env.i2c(), env.usart());
+
+    constexpr int frames                = 20;
+    constexpr std::size_t scene_sizes[] = {0, 16, 64, 256, 1024, 2048, 4096};
+    constexpr uint16_t triangle_sizes[] = {4, 16};
+
+    printf("Rasterizer benchmark (%s edges): %d frames per scene\n", name, frames);
+    printf("%10s | %10s | %16s | %16s\n", "triangles", "size [px]", "add [us/frame]",
+           "render [us/frame]");
+    for (const auto triangle_size : triangle_sizes)
+    {
+        for (const auto triangles : scene_sizes)
+        {
+            const double add_time = measure_us(
+                frames, [&mode] { mode->clear(); },
+                [&mode, triangles, triangle_size] {
+                    submit_scene(*mode, triangles, triangle_size);
+                });
+
+            const double render_time = measure_us(
+                frames,
+                [&mode, triangles, triangle_size] {
+                    mode->clear();
+                    submit_scene(*mode, triangles, triangle_size);
+                },
+                [&mode] { mode->render(); });
+
+            printf("%10zu | %10d | %16.1f | %16.1f\n", triangles, triangle_size, add_time,
+                   render_time);
+        }
+    }
+}
+
+} // namespace msgpu::benchmark
+
+int main()
+{
+    using namespace msgpu::benchmark;
+
+    static Environment env;
+    env.framebuffer().set_resolution(Configuration::resolution_width,
+                                     Configuration::resolution_height);
+
+    run<FloatMode>(env, "float");
+    run<FixedPointMode>(env, "16.16 fixed point");
+    return 0;
+}
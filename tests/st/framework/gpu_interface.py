@@ -19,12 +19,33 @@ import sys
 
 class GpuInterface:
     start_token = struct.pack("B", 0x7e)
+    # frames with sequence number, sent in windowed mode
+    windowed_start_token = struct.pack("B", 0x7d)
+    # acknowledgements sent by GPU in windowed mode
+    link_control_token = struct.pack("B", 0x7b)
+    link_ack = 0x06
+    link_nak = 0x15
+    # large blocks of buffer data or program binary, sent in windowed mode
+    bulk_start_token = struct.pack("B", 0x7c)
+    bulk_buffer_data = 1
+    bulk_program_data = 2
+    # must match UsartPoint::bulk_block_size and UsartPoint::bulk_blocks
+    bulk_block_size = 2048
+    bulk_blocks = 4
 
-    def __init__(self, gpu_in_file, gpu_out_file):
+    def __init__(self, gpu_in_file, gpu_out_file, window_size=0, retransmit_timeout=0.5):
+        """window_size - frames sent without acknowledgement, 0 disables windowed mode"""
         counter = 0
         self._gpuin = None
         self._gpuout = None
         self._logger = Logger("GpuIO")
+        self._window_size = window_size
+        self._retransmit_timeout = retransmit_timeout
+        self._next_sequence = 0
+        # (sequence, frame) not acknowledged yet, oldest first
+        self._in_flight = []
+        # messages received while waiting for acknowledgements
+        self._received = []
         while counter < 5:
             if self._gpuout == None and os.path.exists(gpu_out_file):
                 self._gpuout_fd = os.open(gpu_out_file, os.O_WRONLY)
@@ -32,7 +53,8 @@ class GpuInterface:
                 self._gpuout.flush()
                 self._logger.log("Gpu out initialized from:", gpu_out_file)
             if self._gpuin == None and os.path.exists(gpu_in_file) and self._gpuout != None:
-                self._gpuin = open(gpu_in_file, "rb")
+                # unbuffered, select must see all not consumed data
+                self._gpuin = open(gpu_in_file, "rb", buffering=0)
                 self._gpuin.flush()
                 self._logger.log("Gpu input initialized from:", gpu_in_file)
             if self._gpuin != None and self._gpuout != None:
@@ -60,17 +82,30 @@ class GpuInterface:
 
         return (int(r), int(g), int(b))
 
-    def dump_frame(self, output_name, verify_with=None):
+    def _read_pixel(self, line_address, x, bits_per_pixel):
+        if bits_per_pixel == 4:
+            byte = self._memory[line_address + x // 2]
+            return (byte >> ((x % 2) * 4)) & 0x0f
+        if bits_per_pixel == 8:
+            return self._memory[line_address + x]
+        return self._memory[line_address + 2 * x]
+
+    def dump_frame(self, output_name, verify_with=None, buffer_id=1, bits_per_pixel=8):
         height = 240
         width = 320
         img = []
 
+        # packed formats use tight stride, 16-bit format keeps line per 1024 bytes page
+        stride = 1024 if bits_per_pixel == 16 else (width * bits_per_pixel + 7) // 8
+        buffer_address = stride * height * buffer_id
+
         for y in range(height):
             row = ()
-            index = 1024*y
+            line_address = buffer_address + stride * y
             for x in range(width):
-                row = row + self.from_rgb332(self._memory[index])
-                index += 2
+                row = row + \
+                    self.from_rgb332(self._read_pixel(
+                        line_address, x, bits_per_pixel))
             img.append(row)
         w = png.Writer(width, height, greyscale=False)
         with open(output_name, "wb") as f:
@@ -105,6 +140,10 @@ class GpuInterface:
         payload = msg.dumps()
         h.size = len(payload)
 
+        if self._window_size:
+            self._write_windowed(h, payload)
+            return
+
         header_crc = self._calculate_crc(h.dumps())
         self._gpuout.write(GpuInterface.start_token)
         self._gpuout.flush()
@@ -123,25 +162,132 @@ class GpuInterface:
                     return key
         return None
 
+    def _write_windowed(self, h, payload):
+        while len(self._in_flight) >= self._window_size:
+            self._wait_for_frame()
+
+        sequence = self._next_sequence
+        self._next_sequence = (sequence + 1) % 256
+
+        # header CRC protects also sequence number
+        header = struct.pack("B", sequence) + h.dumps()
+        frame = GpuInterface.windowed_start_token + header + \
+            struct.pack("H", self._calculate_crc(header)) + payload + \
+            struct.pack("H", self._calculate_crc(payload))
+        self._in_flight.append((sequence, frame))
+        self._send_frame(frame)
+
+    def write_bulk(self, kind, data):
+        """Sends data in bulk frames, requires windowed mode"""
+        assert self._window_size, "Bulk frames are supported only in windowed mode"
+        for index in range(0, len(data), GpuInterface.bulk_block_size):
+            self._write_bulk_block(
+                kind, data[index:index + GpuInterface.bulk_block_size])
+
+    def _bulk_in_flight(self):
+        return sum(1 for _, frame in self._in_flight
+                   if frame[:1] == GpuInterface.bulk_start_token)
+
+    def _write_bulk_block(self, kind, block):
+        # GPU releases block on next message, so one block must stay free
+        while len(self._in_flight) >= self._window_size or \
+                self._bulk_in_flight() >= GpuInterface.bulk_blocks - 1:
+            self._wait_for_frame()
+
+        sequence = self._next_sequence
+        self._next_sequence = (sequence + 1) % 256
+
+        header = struct.pack("<BBH", sequence, kind, len(block))
+        frame = GpuInterface.bulk_start_token + header + \
+            struct.pack("H", self._calculate_crc(header)) + block + \
+            struct.pack("H", self._calculate_crc(block))
+        self._in_flight.append((sequence, frame))
+        self._send_frame(frame)
+
+    def flush(self):
+        """Waits until all frames sent in windowed mode are acknowledged"""
+        while self._in_flight:
+            self._wait_for_frame()
+
+    def _send_frame(self, frame):
+        self._gpuout.write(frame)
+        self._gpuout.flush()
+
+    def _retransmit_from(self, index):
+        for _, frame in self._in_flight[index:]:
+            self._send_frame(frame)
+
+    def _find_in_flight(self, sequence):
+        for index, (frame_sequence, _) in enumerate(self._in_flight):
+            if frame_sequence == sequence:
+                return index
+        return None
+
+    def _process_link_control(self):
+        control = self._read_exact(2)
+        crc = struct.unpack("H", self._read_exact(2))[0]
+        if crc != self._calculate_crc(control):
+            # lost acknowledgement is recovered by timeout
+            self._logger.log("Link control CRC verification failed")
+            return
+
+        control_type, sequence = struct.unpack("BB", control)
+        index = self._find_in_flight(sequence)
+        if index is None:
+            return
+        if control_type == GpuInterface.link_ack:
+            # acknowledgement is cumulative
+            del self._in_flight[:index + 1]
+        elif control_type == GpuInterface.link_nak:
+            self._retransmit_from(index)
+
+    def _wait_for_frame(self):
+        """Processes single frame from GPU, retransmits not acknowledged frames on timeout"""
+        timeout = self._retransmit_timeout if self._in_flight else None
+        readable, _, _ = select.select([self._gpuin], [], [], timeout)
+        if not readable:
+            self._retransmit_from(0)
+            return
+
+        b = self._read_exact(1)
+        if b == GpuInterface.link_control_token:
+            self._process_link_control()
+        elif b == GpuInterface.start_token:
+            self._received.append(self._read_message())
+
+    def _read_exact(self, size):
+        data = b""
+        while len(data) < size:
+            chunk = self._gpuin.read(size - len(data))
+            assert chunk, "GPU output closed"
+            data += chunk
+        return data
+
     def read(self):
+        if self._window_size:
+            while not self._received:
+                self._wait_for_frame()
+            return self._received.pop(0)
+
         b = 0
-        counter = 0
         while b != GpuInterface.start_token:
-            b = self._gpuin.read(1)
+            b = self._read_exact(1)
+        return self._read_message()
 
-        payload = self._gpuin.read(len(Header))
+    def _read_message(self):
+        payload = self._read_exact(len(Header))
         h = Header(payload)
 
-        h_crc = struct.unpack("H", self._gpuin.read(2))[0]
+        h_crc = struct.unpack("H", self._read_exact(2))[0]
         calculated_crc = self._calculate_crc(payload)
         if h_crc != calculated_crc:
             print("CRC verification failed, got: ", hex(
                 h_crc), ", calculated: ", hex(calculated_crc))
             assert(False)
 
-        data_payload = self._gpuin.read(h.size)
+        data_payload = self._read_exact(h.size)
 
-        data_crc = struct.unpack("H", self._gpuin.read(2))[0]
+        data_crc = struct.unpack("H", self._read_exact(2))[0]
         calculated_crc = self._calculate_crc(data_payload)
         if data_crc != calculated_crc:
             print("CRC verification failed, got: ", hex(
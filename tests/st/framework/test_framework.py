@@ -10,7 +10,7 @@ from tests.log import Logger, log
 
 
 class SUT:
-    def __init__(self, path):
+    def __init__(self, path, window_size=0):
         self._logger = Logger("SUT")
         self._logger.log("Open application:", path)
 
@@ -21,7 +21,7 @@ class SUT:
         # order is important, GPUIO waits for streams created by SUT
         self._logger.log("Initialize GPU/IO")
         self._gpuio = GpuInterface(
-            st_config.gpu_io_in_path, st_config.gpu_io_out_path)
+            st_config.gpu_io_in_path, st_config.gpu_io_out_path, window_size)
 
         self._logger.log("Initialize I2C")
         self._i2c = I2CInterface(
@@ -2,3 +2,4 @@
 i2c_ack = bytearray([0xac, 0x88])
 
 i2c_swap_id = 0x03
+i2c_framebuffer_format_id = 0x04
@@ -7,6 +7,7 @@ from unittest import TestCase
 import st_config
 
 from framework.test_framework import SUT
+from framework.gpu_interface import GpuInterface
 
 from messages.allocate_program import AllocateProgramRequest, AllocateProgramType
 from messages.attach_shader import AttachShader
@@ -23,10 +24,17 @@ from messages.set_vertex_attrib import SetVertexAttrib
 from messages.get_named_parameter_id import GetNamedParameterIdReq, GetNamedParameterIdResp
 from messages.change_mode import ChangeMode
 
+from i2c_messages.i2c_messages import i2c_ack, i2c_framebuffer_format_id
+
 
 class TestBase(TestCase):
+    # frames in flight, must not exceed UsartPoint::window_size
+    window_size = 8
+
     def setUp(self) -> None:
-        self.sut = SUT(st_config.path_to_msgpu)
+        self.sut = SUT(st_config.path_to_msgpu, self.window_size)
+        # default mode is 320x240 with 256 colours
+        self.expect_framebuffer_format(8)
 
     def tearDown(self) -> None:
         self.sut.close()
@@ -43,6 +51,11 @@ class TestBase(TestCase):
         msg.program_id = program_id
         msg.size = os.path.getsize(path)
         self.sut.gpu_io().write(msg)
+        if self.window_size:
+            with open(path, "rb") as file:
+                self.sut.gpu_io().write_bulk(GpuInterface.bulk_program_data, file.read())
+            return
+
         chunk_size = len(ProgramWrite().data)
         with open(path, "rb") as file:
 
@@ -80,6 +93,16 @@ class TestBase(TestCase):
         msg.first = first
         self.sut.gpu_io().write(msg)
 
+    def draw_elements(self, draw_type, index_type, count, offset):
+        # available when interface generates messages/draw_elements.th
+        from messages.draw_elements import DrawElements, DrawElementsType
+        msg = DrawElements()
+        msg.mode = DrawArrayMode.values[draw_type]
+        msg.type = DrawElementsType.values[index_type]
+        msg.count = count
+        msg.offset = offset
+        self.sut.gpu_io().write(msg)
+
     def add_pixel_shader(self, shader_path, program_id):
         self.write_shader(shader_path, program_id, "AllocateFragmentShader")
 
@@ -119,6 +142,9 @@ class TestBase(TestCase):
         msg.usage = BufferDataUsage.values["StaticDraw"]
         msg.size = len(data)
         self.sut.gpu_io().write(msg)
+        if self.window_size:
+            self.sut.gpu_io().write_bulk(GpuInterface.bulk_buffer_data, data)
+            return
 
         index = 0
         part = 0
@@ -167,3 +193,9 @@ class TestBase(TestCase):
         req = ChangeMode()
         req.mode = mode
         self.sut.gpu_io().write(req)
+
+    def expect_framebuffer_format(self, bits_per_pixel, compressed=False):
+        msg = self.sut.i2c_io().read(3)
+        assert msg == bytearray([i2c_framebuffer_format_id, bits_per_pixel,
+                                 int(compressed)]), "Framebuffer format not received"
+        self.sut.i2c_io().write(i2c_ack)
@@ -0,0 +1,97 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it is under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "buffers/block_allocator.hpp"
+
+namespace msgpu::buffers
+{
+
+class BlockAllocatorShould : public ::testing::Test
+{
+  protected:
+    BlockAllocator<128> sut_;
+};
+
+TEST_F(BlockAllocatorShould, AllocateConsecutiveBlocks)
+{
+    EXPECT_EQ(sut_.allocate(3), 0u);
+    EXPECT_EQ(sut_.allocate(40), 3u);
+    EXPECT_EQ(sut_.allocate(1), 43u);
+
+    EXPECT_TRUE(sut_.is_used(0));
+    EXPECT_TRUE(sut_.is_used(43));
+    EXPECT_FALSE(sut_.is_used(44));
+}
+
+TEST_F(BlockAllocatorShould, ReuseLowestFreeRange)
+{
+    const uint32_t first  = sut_.allocate(2);
+    const uint32_t second = sut_.allocate(2);
+    sut_.allocate(2);
+
+    sut_.release(second, 2);
+    EXPECT_EQ(sut_.allocate(3), 6u);
+    EXPECT_EQ(sut_.allocate(1), second);
+
+    sut_.release(first, 2);
+    EXPECT_EQ(sut_.allocate(2), first);
+}
+
+TEST_F(BlockAllocatorShould, CoalesceReleasedRanges)
+{
+    const uint32_t first  = sut_.allocate(30);
+    const uint32_t second = sut_.allocate(30);
+    sut_.allocate(68);
+    EXPECT_EQ(sut_.allocate(1), sut_.npos);
+
+    sut_.release(first, 30);
+    sut_.release(second, 30);
+    // range crosses bitmap words
+    EXPECT_EQ(sut_.allocate(60), 0u);
+}
+
+TEST_F(BlockAllocatorShould, RejectTooLargeAllocation)
+{
+    EXPECT_EQ(sut_.allocate(129), sut_.npos);
+    EXPECT_EQ(sut_.allocate(0), sut_.npos);
+    EXPECT_EQ(sut_.allocate(128), 0u);
+    EXPECT_EQ(sut_.allocate(1), sut_.npos);
+}
+
+TEST_F(BlockAllocatorShould, ReportFragmentation)
+{
+    AllocationStatistics statistics = sut_.statistics();
+    EXPECT_EQ(statistics.free, 128u);
+    EXPECT_EQ(statistics.largest_free, 128u);
+    EXPECT_EQ(statistics.fragments, 1u);
+
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        sut_.allocate(16);
+    }
+    sut_.release(16, 16);
+    sut_.release(64, 16);
+    sut_.release(80, 4);
+
+    statistics = sut_.statistics();
+    EXPECT_EQ(statistics.free, 36u);
+    EXPECT_EQ(statistics.largest_free, 20u);
+    EXPECT_EQ(statistics.fragments, 2u);
+}
+
+} // namespace msgpu::buffers
@@ -14,6 +14,9 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+#include <algorithm>
+#include <span>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -122,4 +125,111 @@ TEST_F(GpuBuffersShould, AllocateMemoryWithCorrectSlots)
     sut_.write(id, data, sizeof(data));
 }
 
+TEST_F(GpuBuffersShould, RejectAllocationWithoutFreeMemory)
+{
+    constexpr std::size_t block_size = 1024;
+    constexpr std::size_t blocks     = 8 * 1024;
+
+    uint16_t ids[2];
+    sut_.allocate_names(2, ids);
+
+    EXPECT_TRUE(sut_.allocate_memory(ids[0], (blocks - 1) * block_size));
+    EXPECT_FALSE(sut_.allocate_memory(ids[1], 2 * block_size));
+    EXPECT_TRUE(sut_.allocate_memory(ids[1], block_size));
+
+    const AllocationStatistics statistics = sut_.memory_statistics();
+    EXPECT_EQ(statistics.free, 0u);
+    EXPECT_EQ(statistics.fragments, 0u);
+}
+
+TEST_F(GpuBuffersShould, AddressWholeMemory)
+{
+    constexpr std::size_t block_size = 1024;
+
+    uint16_t ids[2];
+    sut_.allocate_names(2, ids);
+
+    uint8_t data[4] = {};
+    EXPECT_TRUE(sut_.allocate_memory(ids[0], 6 * 1024 * block_size));
+    EXPECT_TRUE(sut_.allocate_memory(ids[1], block_size));
+
+    EXPECT_CALL(memory_, write(6 * 1024 * block_size, data, sizeof(data)));
+    sut_.write(ids[1], data, sizeof(data));
+}
+
+TEST_F(GpuBuffersShould, PackSmallBuffersIntoSingleBlock)
+{
+    constexpr std::size_t block_size = 1024;
+
+    uint16_t ids[4];
+    sut_.allocate_names(4, ids);
+
+    uint8_t data[36] = {};
+    EXPECT_TRUE(sut_.allocate_memory(ids[0], 36));
+    EXPECT_TRUE(sut_.allocate_memory(ids[1], 36));
+    EXPECT_TRUE(sut_.allocate_memory(ids[2], 20));
+    EXPECT_TRUE(sut_.allocate_memory(ids[3], 2 * block_size));
+
+    // 36 bytes use 64 bytes slots, 20 bytes use 32 bytes slot in next block
+    EXPECT_CALL(memory_, write(0, data, sizeof(data)));
+    EXPECT_CALL(memory_, write(64, data, sizeof(data)));
+    EXPECT_CALL(memory_, write(block_size, data, 20));
+    EXPECT_CALL(memory_, write(2 * block_size, data, sizeof(data)));
+    sut_.write(ids[0], data, sizeof(data));
+    sut_.write(ids[1], data, sizeof(data));
+    sut_.write(ids[2], data, 20);
+    sut_.write(ids[3], data, sizeof(data));
+
+    // block is returned when all slots are released
+    sut_.release_names(1, &ids[2]);
+    sut_.allocate_names(1, &ids[2]);
+    EXPECT_TRUE(sut_.allocate_memory(ids[2], block_size));
+    EXPECT_CALL(memory_, write(block_size, data, sizeof(data)));
+    sut_.write(ids[2], data, sizeof(data));
+}
+
+TEST_F(GpuBuffersShould, LimitWritesToBufferSize)
+{
+    uint16_t id;
+    sut_.allocate_names(1, &id);
+    EXPECT_TRUE(sut_.allocate_memory(id, 36));
+
+    uint8_t data[64] = {};
+    EXPECT_CALL(memory_, write(::testing::_, ::testing::_, ::testing::_)).Times(0);
+    EXPECT_CALL(memory_, write(0, data, 36));
+    EXPECT_CALL(memory_, write(32, data, 4));
+
+    // slab slot has 64 bytes, but buffer ends after 36 bytes
+    sut_.write(id, data, sizeof(data));
+    sut_.write(id, data, sizeof(data), 32);
+    sut_.write(id, data, sizeof(data), 36);
+}
+
+TEST_F(GpuBuffersShould, ZeroPartOfReadOutsideOfBuffer)
+{
+    uint16_t id;
+    sut_.allocate_names(1, &id);
+    EXPECT_TRUE(sut_.allocate_memory(id, 36));
+
+    uint8_t data[40];
+    std::fill(std::begin(data), std::end(data), 0xff);
+    EXPECT_CALL(memory_, read(4, data, 32)).WillOnce(::testing::Return(32));
+
+    sut_.read(id, data, sizeof(data), 4);
+    EXPECT_EQ(data[31], 0xff);
+    EXPECT_THAT(std::span<const uint8_t>(data).subspan(32), ::testing::Each(0));
+}
+
+TEST_F(GpuBuffersShould, RejectAccessToUnknownBuffers)
+{
+    uint8_t data[4] = {1, 2, 3, 4};
+    EXPECT_CALL(memory_, write(::testing::_, ::testing::_, ::testing::_)).Times(0);
+    EXPECT_CALL(memory_, read(::testing::_, ::testing::_, ::testing::_)).Times(0);
+
+    sut_.write(5, data, sizeof(data));
+    sut_.write(0xffff, data, sizeof(data));
+    sut_.read(0xffff, data, sizeof(data));
+    EXPECT_THAT(data, ::testing::Each(0));
+}
+
 } // namespace msgpu::buffers
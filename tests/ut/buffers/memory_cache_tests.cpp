@@ -0,0 +1,192 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it is under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "buffers/memory_cache.hpp"
+
+#include "memory_mock.hpp"
+
+namespace msgpu::buffers
+{
+
+using ::testing::_;
+
+class MemoryCacheShould : public ::testing::Test
+{
+  public:
+    using Cache = MemoryCache<mocks::MemoryMock, 16, 4, 2>;
+
+    MemoryCacheShould()
+        : memory_()
+        , data_(1024)
+    {
+        std::iota(data_.begin(), data_.end(), uint8_t{0});
+        ON_CALL(memory_, read(_, _, _))
+            .WillByDefault([this](std::size_t address, void *data, std::size_t size) {
+                std::memcpy(data, data_.data() + address, size);
+                return size;
+            });
+        ON_CALL(memory_, write(_, _, _))
+            .WillByDefault([this](std::size_t address, const void *data, std::size_t size) {
+                std::memcpy(data_.data() + address, data, size);
+                return size;
+            });
+    }
+
+  protected:
+    ::testing::NiceMock<mocks::MemoryMock> memory_;
+    std::vector<uint8_t> data_;
+};
+
+TEST_F(MemoryCacheShould, ServeRepeatedReadsFromCache)
+{
+    Cache sut(memory_);
+    uint8_t out[20];
+
+    EXPECT_CALL(memory_, read(16, _, 16));
+    EXPECT_CALL(memory_, read(32, _, 16));
+    EXPECT_EQ(sut.read(20, out, sizeof(out)), sizeof(out));
+    EXPECT_EQ(out[0], 20);
+    EXPECT_EQ(out[19], 39);
+
+    ::testing::Mock::VerifyAndClearExpectations(&memory_);
+    EXPECT_CALL(memory_, read(_, _, _)).Times(0);
+    sut.read(24, out, 8);
+    EXPECT_EQ(out[0], 24);
+
+    EXPECT_EQ(sut.statistics().read_hits, 1);
+    EXPECT_EQ(sut.statistics().read_misses, 2);
+    EXPECT_EQ(sut.read_hit_rate(), 33);
+}
+
+TEST_F(MemoryCacheShould, EvictLeastRecentlyUsedLine)
+{
+    Cache sut(memory_);
+    uint8_t out[1];
+
+    // lines 0, 4 and 8 share set 0 which has two ways
+    sut.read(0, out, 1);
+    sut.read(64, out, 1);
+    sut.read(0, out, 1);
+    sut.read(128, out, 1);
+
+    EXPECT_CALL(memory_, read(0, _, _)).Times(0);
+    EXPECT_CALL(memory_, read(64, _, 16));
+    sut.read(0, out, 1);
+    sut.read(64, out, 1);
+    EXPECT_EQ(out[0], 64);
+}
+
+TEST_F(MemoryCacheShould, UpdateCachedLinesOnWriteThrough)
+{
+    Cache sut(memory_);
+    uint8_t out[4];
+    const uint8_t in[4] = {0xaa, 0xbb, 0xcc, 0xdd};
+
+    sut.read(0, out, sizeof(out));
+    EXPECT_CALL(memory_, write(2, _, 4));
+    sut.write(2, in, sizeof(in));
+
+    EXPECT_CALL(memory_, read(_, _, _)).Times(0);
+    sut.read(0, out, sizeof(out));
+    EXPECT_THAT(out, ::testing::ElementsAre(0, 1, 0xaa, 0xbb));
+    EXPECT_EQ(data_[5], 0xdd);
+}
+
+TEST_F(MemoryCacheShould, DeferWritesUntilFlushOnWriteBack)
+{
+    Cache sut(memory_, WritePolicy::WriteBack);
+    uint8_t in[16];
+    std::fill(std::begin(in), std::end(in), 0x55);
+
+    // whole line is overwritten, so it isn't read
+    EXPECT_CALL(memory_, read(_, _, _)).Times(0);
+    EXPECT_CALL(memory_, write(_, _, _)).Times(0);
+    sut.write(48, in, sizeof(in));
+    uint8_t out[2];
+    sut.read(62, out, sizeof(out));
+    EXPECT_THAT(out, ::testing::ElementsAre(0x55, 0x55));
+    EXPECT_EQ(data_[48], 48);
+
+    ::testing::Mock::VerifyAndClearExpectations(&memory_);
+    EXPECT_CALL(memory_, write(48, _, 16));
+    sut.flush();
+    EXPECT_EQ(data_[48], 0x55);
+    EXPECT_EQ(sut.statistics().write_backs, 1);
+
+    // line is clean now
+    sut.flush();
+}
+
+TEST_F(MemoryCacheShould, WriteBackEvictedDirtyLine)
+{
+    Cache sut(memory_, WritePolicy::WriteBack);
+    const uint8_t in[2] = {0xf0, 0xf1};
+
+    // partially written line is read first
+    EXPECT_CALL(memory_, read(0, _, 16));
+    sut.write(4, in, sizeof(in));
+    ::testing::Mock::VerifyAndClearExpectations(&memory_);
+
+    uint8_t out[1];
+    sut.read(64, out, 1);
+    EXPECT_CALL(memory_, write(0, _, 16));
+    EXPECT_CALL(memory_, read(128, _, 16));
+    sut.read(128, out, 1);
+    EXPECT_EQ(data_[4], 0xf0);
+    EXPECT_EQ(data_[6], 6);
+}
+
+TEST_F(MemoryCacheShould, RereadInvalidatedLines)
+{
+    Cache sut(memory_);
+    uint8_t out[1];
+
+    sut.read(100, out, 1);
+    data_[100] = 0x77;
+    sut.read(100, out, 1);
+    EXPECT_EQ(out[0], 100);
+
+    sut.invalidate(90, 20);
+    EXPECT_CALL(memory_, read(96, _, 16));
+    sut.read(100, out, 1);
+    EXPECT_EQ(out[0], 0x77);
+}
+
+TEST_F(MemoryCacheShould, BypassAccessesLargerThanCache)
+{
+    Cache sut(memory_, WritePolicy::WriteBack);
+    const uint8_t in[1] = {0x11};
+    sut.write(3, in, 1);
+
+    // dirty line must be stored before memory is read directly
+    uint8_t out[80];
+    ::testing::InSequence sequence;
+    EXPECT_CALL(memory_, write(0, _, 16));
+    EXPECT_CALL(memory_, read(0, _, sizeof(out)));
+    sut.read(0, out, sizeof(out));
+
+    EXPECT_EQ(out[3], 0x11);
+    EXPECT_EQ(sut.statistics().bypassed, 1);
+}
+
+} // namespace msgpu::buffers
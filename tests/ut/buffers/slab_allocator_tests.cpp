@@ -0,0 +1,92 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it is under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gtest/gtest.h>
+
+#include "buffers/block_allocator.hpp"
+#include "buffers/slab_allocator.hpp"
+
+namespace msgpu::buffers
+{
+
+class SlabAllocatorShould : public ::testing::Test
+{
+  public:
+    SlabAllocatorShould()
+        : blocks_()
+        , sut_(blocks_)
+    {
+    }
+
+  protected:
+    constexpr static std::size_t block_size = 1024;
+
+    BlockAllocator<64> blocks_;
+    SlabAllocator<BlockAllocator<64>, block_size, 4> sut_;
+};
+
+TEST_F(SlabAllocatorShould, PlaceBuffersOfTheSameClassInOneBlock)
+{
+    const SlabAllocation first  = sut_.allocate(100);
+    const SlabAllocation second = sut_.allocate(128);
+    EXPECT_EQ(first.address, 0u);
+    EXPECT_EQ(second.address, 128u);
+    EXPECT_EQ(first.slab, second.slab);
+    EXPECT_EQ(blocks_.statistics().free, 63u);
+}
+
+TEST_F(SlabAllocatorShould, UseSeparateSlabForEachClass)
+{
+    EXPECT_EQ(sut_.allocate(32).address, 0u);
+    EXPECT_EQ(sut_.allocate(512).address, block_size);
+    EXPECT_EQ(sut_.allocate(33).address, 2 * block_size);
+    EXPECT_EQ(sut_.allocate(1).address, 32u);
+}
+
+TEST_F(SlabAllocatorShould, StartNewSlabWhenSlabIsFull)
+{
+    EXPECT_EQ(sut_.allocate(512).address, 0u);
+    const SlabAllocation second = sut_.allocate(512);
+    EXPECT_EQ(second.address, 512u);
+    EXPECT_EQ(sut_.allocate(512).address, block_size);
+
+    sut_.release(second);
+    EXPECT_EQ(sut_.allocate(300).address, 512u);
+}
+
+TEST_F(SlabAllocatorShould, ReturnEmptySlabToBlockAllocator)
+{
+    const SlabAllocation first  = sut_.allocate(64);
+    const SlabAllocation second = sut_.allocate(64);
+    EXPECT_EQ(blocks_.statistics().free, 63u);
+
+    sut_.release(first);
+    EXPECT_EQ(blocks_.statistics().free, 63u);
+    sut_.release(second);
+    EXPECT_EQ(blocks_.statistics().free, 64u);
+}
+
+TEST_F(SlabAllocatorShould, FailWhenAllSlabsAreUsed)
+{
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        EXPECT_NE(sut_.allocate(512).slab, sut_.no_slab);
+        EXPECT_NE(sut_.allocate(512).slab, sut_.no_slab);
+    }
+    EXPECT_EQ(sut_.allocate(512).slab, sut_.no_slab);
+}
+
+} // namespace msgpu::buffers
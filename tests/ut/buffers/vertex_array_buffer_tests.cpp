@@ -14,6 +14,8 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
+#include <cstring>
+
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
@@ -24,6 +26,19 @@
 namespace msgpu::buffers
 {
 
+using ::testing::_;
+
+namespace
+{
+
+struct ArrayState
+{
+    uint32_t value;
+    uint16_t buffer;
+};
+
+} // namespace
+
 class VertexArrayBufferShould : public ::testing::Test
 {
   public:
@@ -35,7 +50,7 @@ class VertexArrayBufferShould : public ::testing::Test
 
   protected:
     ::testing::StrictMock<mocks::MemoryMock> memory_;
-    VertexArrayBuffer<mocks::MemoryMock, 128> sut_;
+    VertexArrayBuffer<mocks::MemoryMock, 128, ArrayState, 2> sut_;
 };
 
 TEST_F(VertexArrayBufferShould, AllocateNames)
@@ -62,37 +77,72 @@ TEST_F(VertexArrayBufferShould, ReleaseNames)
     EXPECT_THAT(ids, ::testing::ElementsAreArray({0, 2, 4, 5}));
 }
 
-TEST_F(VertexArrayBufferShould, WriteDataToBuffer)
+TEST_F(VertexArrayBufferShould, BindNewArrayWithoutMemoryAccess)
+{
+    EXPECT_EQ(sut_.bind(0), nullptr);
+
+    uint16_t ids[1];
+    sut_.allocate_names(1, ids);
+
+    const ArrayState *state = sut_.bind(ids[0]);
+    ASSERT_NE(state, nullptr);
+    EXPECT_EQ(state->value, 0);
+    EXPECT_EQ(state->buffer, 0);
+}
+
+TEST_F(VertexArrayBufferShould, KeepModifiedStatesResident)
 {
-    VertexArrayBufferData data{
-        .size       = 3,
-        .normalized = 1,
-        .type       = 3,
-        .index      = 1,
-        .stride     = 123,
-    };
-
-    VertexArrayBufferData data2{
-        .size       = 9,
-        .normalized = 0,
-        .type       = 93,
-        .index      = 4,
-        .stride     = 23,
-    };
-
-    EXPECT_FALSE(sut_.set(0, data));
     uint16_t ids[2];
     sut_.allocate_names(2, ids);
 
-    EXPECT_CALL(memory_, write(sut_.start_address, &data, sizeof(VertexArrayBufferData))).Times(1);
+    sut_.modify(ids[0])->value = 10;
+    sut_.modify(ids[1])->value = 20;
+
+    EXPECT_EQ(sut_.bind(ids[0])->value, 10);
+    EXPECT_EQ(sut_.bind(ids[1])->value, 20);
+    EXPECT_EQ(sut_.bind(ids[1]), sut_.modify(ids[1]));
+}
 
-    EXPECT_TRUE(sut_.set(ids[0], data));
+TEST_F(VertexArrayBufferShould, WriteBackEvictedModifiedState)
+{
+    uint16_t ids[3];
+    sut_.allocate_names(3, ids);
+
+    sut_.modify(ids[0])->value = 10;
+    sut_.modify(ids[1])->value = 20;
+    sut_.bind(ids[1]);
+
+    ArrayState stored{};
+    EXPECT_CALL(memory_, write(sut_.start_address, _, sizeof(ArrayState)))
+        .WillOnce([&stored](std::size_t, const void *data, std::size_t size) {
+            std::memcpy(&stored, data, size);
+            return size;
+        });
+    EXPECT_EQ(sut_.bind(ids[2])->value, 0);
+    EXPECT_EQ(stored.value, 10);
+
+    // second array is least recently used now
+    EXPECT_CALL(memory_, write(sut_.start_address + sizeof(ArrayState), _, sizeof(ArrayState)));
+    EXPECT_CALL(memory_, read(sut_.start_address, _, sizeof(ArrayState)))
+        .WillOnce([&stored](std::size_t, void *data, std::size_t size) {
+            std::memcpy(data, &stored, size);
+            return size;
+        });
+    EXPECT_EQ(sut_.bind(ids[0])->value, 10);
+}
+
+TEST_F(VertexArrayBufferShould, DropStateOfReleasedArray)
+{
+    uint16_t ids[1];
+    sut_.allocate_names(1, ids);
+    sut_.modify(ids[0])->value = 10;
 
-    EXPECT_CALL(memory_, write(sut_.start_address + sizeof(VertexArrayBufferData), &data2,
-                               sizeof(VertexArrayBufferData)))
-        .Times(1);
+    sut_.release_names(1, ids);
+    EXPECT_EQ(sut_.bind(ids[0]), nullptr);
 
-    EXPECT_TRUE(sut_.set(ids[1], data2));
+    sut_.allocate_names(1, ids);
+    EXPECT_EQ(sut_.bind(ids[0])->value, 0);
+    sut_.flush();
 }
 
 } // namespace msgpu::buffers
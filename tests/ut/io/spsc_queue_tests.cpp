@@ -0,0 +1,103 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "io/spsc_queue.hpp"
+
+namespace msgpu::io
+{
+
+TEST(SpscQueueShould, ReturnElementsInOrder)
+{
+    SpscQueue<int, 4> sut;
+    EXPECT_TRUE(sut.empty());
+    EXPECT_EQ(sut.front(), nullptr);
+
+    EXPECT_TRUE(sut.push(1));
+    EXPECT_TRUE(sut.push(2));
+    EXPECT_EQ(sut.size(), 2u);
+
+    ASSERT_NE(sut.front(), nullptr);
+    EXPECT_EQ(*sut.front(), 1);
+    sut.pop();
+    ASSERT_NE(sut.front(), nullptr);
+    EXPECT_EQ(*sut.front(), 2);
+    sut.pop();
+    EXPECT_TRUE(sut.empty());
+}
+
+TEST(SpscQueueShould, RejectElementsWhenFull)
+{
+    SpscQueue<int, 2> sut;
+    EXPECT_TRUE(sut.push(1));
+    EXPECT_TRUE(sut.push(2));
+    EXPECT_FALSE(sut.push(3));
+    EXPECT_EQ(sut.acquire(), nullptr);
+
+    sut.pop();
+    EXPECT_TRUE(sut.push(3));
+    EXPECT_EQ(*sut.front(), 2);
+}
+
+TEST(SpscQueueShould, PublishOnlyCommittedSlots)
+{
+    SpscQueue<int, 4> sut;
+    int *slot = sut.acquire();
+    ASSERT_NE(slot, nullptr);
+    *slot = 10;
+    EXPECT_TRUE(sut.empty());
+
+    // not committed slot is reused
+    EXPECT_EQ(sut.acquire(), slot);
+    *slot = 11;
+    sut.commit();
+    ASSERT_EQ(sut.front(), slot);
+    EXPECT_EQ(*sut.front(), 11);
+}
+
+TEST(SpscQueueShould, TransferElementsBetweenThreads)
+{
+    constexpr int elements = 100000;
+    SpscQueue<int, 16> sut;
+
+    std::thread producer([&sut] {
+        for (int i = 0; i < elements; ++i)
+        {
+            while (!sut.push(i))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (int i = 0; i < elements; ++i)
+    {
+        int *element = sut.front();
+        while (element == nullptr)
+        {
+            std::this_thread::yield();
+            element = sut.front();
+        }
+        ASSERT_EQ(*element, i);
+        sut.pop();
+    }
+    producer.join();
+}
+
+} // namespace msgpu::io
@@ -19,6 +19,9 @@
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
+#include <eul/crc/crc.hpp>
+
+#include "tests/ut/mocks/arch/board_stubs.hpp"
 #include "tests/ut/mocks/arch/hal_dma_mocks.hpp"
 
 #include "io/usart_point.hpp"
@@ -28,6 +31,8 @@
 HalDmaMock* hal_dma_mock;
 
 constexpr uint8_t frame_start_byte = 0x7e;
+constexpr uint8_t windowed_frame_start_byte = 0x7d;
+constexpr uint8_t bulk_frame_start_byte = 0x7c;
 
 namespace msgpu::io 
 {
@@ -39,6 +44,7 @@ protected:
         : sut_(data_)
     {
         hal_dma_mock = &hal_dma_mock_;
+        msgpu::stubs::usart_output().clear();
     }
 
     void TearDown() override
@@ -52,6 +58,88 @@ protected:
         sut_.process_event(dma_finished{});  
     }
 
+    void expect_transfer(std::size_t size, void*& buffer)
+    {
+        EXPECT_CALL(hal_dma_mock_, set_usart_dma_transfer_count(size, true));
+        EXPECT_CALL(hal_dma_mock_, set_usart_dma_buffer(testing::_, false))
+            .WillOnce(testing::SaveArg<0>(&buffer));
+    }
+
+    // Feeds windowed frame without payload, UsartPoint must wait for start token
+    void receive_windowed_frame(void*& buffer, uint8_t sequence, const Header& header, 
+        bool corrupted = false)
+    {
+        std::memcpy(buffer, &windowed_frame_start_byte, sizeof(windowed_frame_start_byte));
+        expect_transfer(1, buffer);
+        notify_dma_complete();
+
+        std::memcpy(buffer, &sequence, sizeof(sequence));
+        expect_transfer(sizeof(Header), buffer);
+        notify_dma_complete();
+
+        std::memcpy(buffer, &header, sizeof(Header));
+        expect_transfer(2, buffer);
+        notify_dma_complete();
+
+        // header CRC covers sequence number too
+        uint8_t protected_data[1 + sizeof(Header)];
+        protected_data[0] = sequence;
+        std::memcpy(&protected_data[1], &header, sizeof(Header));
+        uint16_t crc = calculate_crc16(std::span<const uint8_t>(protected_data));
+        if (corrupted)
+        {
+            crc = static_cast<uint16_t>(~crc);
+        }
+        std::memcpy(buffer, &crc, sizeof(crc));
+        expect_transfer(1, buffer);
+        notify_dma_complete();
+    }
+
+    // Feeds bulk frame, returns false if frame was rejected after header
+    bool receive_bulk_frame(void*& buffer, uint8_t sequence, BulkKind kind, 
+        const std::vector<uint8_t>& payload, bool accepted = true)
+    {
+        std::memcpy(buffer, &bulk_frame_start_byte, sizeof(bulk_frame_start_byte));
+        expect_transfer(4, buffer);
+        notify_dma_complete();
+
+        const uint8_t header[] = {sequence, static_cast<uint8_t>(kind), 
+            static_cast<uint8_t>(payload.size()), static_cast<uint8_t>(payload.size() >> 8)};
+        std::memcpy(buffer, header, sizeof(header));
+        expect_transfer(2, buffer);
+        notify_dma_complete();
+
+        const uint16_t header_crc = calculate_crc16(std::span<const uint8_t>(header));
+        std::memcpy(buffer, &header_crc, sizeof(header_crc));
+        if (!accepted)
+        {
+            expect_transfer(1, buffer);
+            notify_dma_complete();
+            return false;
+        }
+        EXPECT_CALL(hal_dma_mock_, reset_dma_crc());
+        expect_transfer(payload.size(), buffer);
+        notify_dma_complete();
+
+        std::memcpy(buffer, payload.data(), payload.size());
+        const uint16_t crc = calculate_crc16(std::span<const uint8_t>(payload));
+        EXPECT_CALL(hal_dma_mock_, get_dma_crc()).WillOnce(::testing::Return(crc));
+        expect_transfer(2, buffer);
+        notify_dma_complete();
+
+        std::memcpy(buffer, &crc, sizeof(crc));
+        expect_transfer(1, buffer);
+        notify_dma_complete();
+        return true;
+    }
+
+    static std::vector<uint8_t> link_control(uint8_t type, uint8_t sequence)
+    {
+        const uint8_t control[] = {type, sequence};
+        const uint16_t crc = calculate_crc16(std::span<const uint8_t>(control));
+        return {0x7b, type, sequence, static_cast<uint8_t>(crc), static_cast<uint8_t>(crc >> 8)};
+    }
+
     UsartPoint data_;
     boost::sml::sm<UsartPoint> sut_;
 
@@ -793,7 +881,206 @@ TEST_F(UsartPointShould, DropFramesWithWrongPayloadCrc)
 }
 
 
+TEST_F(UsartPointShould, AcknowledgeConsumedWindowedFrames)
+{
+    void* buffer;
+    expect_transfer(1, buffer);
+    sut_.process_event(init{});
 
-} // namespace msgpu::io
+    const Header header {
+        .id = 2,
+        .size = 0,
+    };
+    receive_windowed_frame(buffer, 0, header);
+    receive_windowed_frame(buffer, 1, header);
+
+    // Ack is sent when queue is drained, for last consumed frame
+    const auto msg1 = data_.pop();
+    ASSERT_TRUE(msg1);
+    EXPECT_TRUE(msg1->windowed);
+    EXPECT_EQ(msg1->sequence, 0);
+    EXPECT_TRUE(msgpu::stubs::usart_output().empty());
+
+    const auto msg2 = data_.pop();
+    ASSERT_TRUE(msg2);
+    EXPECT_EQ(msg2->sequence, 1);
+    EXPECT_EQ(msgpu::stubs::usart_output(), link_control(0x06, 1));
+
+    EXPECT_FALSE(data_.pop());
+}
+
+TEST_F(UsartPointShould, RequestRetransmissionWhenWindowedFrameIsMissing)
+{
+    void* buffer;
+    expect_transfer(1, buffer);
+    sut_.process_event(init{});
+
+    const Header header {
+        .id = 2,
+        .size = 0,
+    };
+    receive_windowed_frame(buffer, 0, header);
+    // frame 1 is lost, frames after it are dropped until it is retransmitted
+    receive_windowed_frame(buffer, 2, header);
+    receive_windowed_frame(buffer, 3, header);
+
+    const auto msg1 = data_.pop();
+    ASSERT_TRUE(msg1);
+    EXPECT_EQ(msg1->sequence, 0);
+
+    std::vector<uint8_t> expected = link_control(0x15, 1);
+    const std::vector<uint8_t> ack = link_control(0x06, 0);
+    expected.insert(expected.end(), ack.begin(), ack.end());
+    EXPECT_EQ(msgpu::stubs::usart_output(), expected);
+    EXPECT_FALSE(data_.pop());
+
+    msgpu::stubs::usart_output().clear();
+    receive_windowed_frame(buffer, 1, header);
+    const auto msg2 = data_.pop();
+    ASSERT_TRUE(msg2);
+    EXPECT_EQ(msg2->sequence, 1);
+    EXPECT_EQ(msgpu::stubs::usart_output(), link_control(0x06, 1));
+}
+
+TEST_F(UsartPointShould, RequestRetransmissionOfCorruptedWindowedFrame)
+{
+    void* buffer;
+    expect_transfer(1, buffer);
+    sut_.process_event(init{});
+
+    const Header header {
+        .id = 2,
+        .size = 0,
+    };
+    receive_windowed_frame(buffer, 0, header, true);
+
+    EXPECT_FALSE(data_.pop());
+    EXPECT_EQ(msgpu::stubs::usart_output(), link_control(0x15, 0));
+
+    msgpu::stubs::usart_output().clear();
+    receive_windowed_frame(buffer, 0, header);
+    const auto msg = data_.pop();
+    ASSERT_TRUE(msg);
+    EXPECT_EQ(msg->sequence, 0);
+    EXPECT_EQ(msgpu::stubs::usart_output(), link_control(0x06, 0));
+}
+
+TEST_F(UsartPointShould, ReceiveBulkFrameIntoBlock)
+{
+    void* buffer;
+    expect_transfer(1, buffer);
+    sut_.process_event(init{});
+
+    std::vector<uint8_t> payload(1500);
+    for (std::size_t i = 0; i < payload.size(); ++i)
+    {
+        payload[i] = static_cast<uint8_t>(i * 7);
+    }
+    receive_bulk_frame(buffer, 0, BulkKind::ProgramData, payload);
+
+    const auto msg = data_.pop();
+    ASSERT_TRUE(msg);
+    EXPECT_EQ(msg->bulk, BulkKind::ProgramData);
+    EXPECT_EQ(msg->sequence, 0);
+    EXPECT_EQ(std::vector<uint8_t>(msg->bulk_data.begin(), msg->bulk_data.end()), payload);
+    EXPECT_EQ(msgpu::stubs::usart_output(), link_control(0x06, 0));
+}
+
+TEST_F(UsartPointShould, RejectBulkFrameWhenAllBlocksAreUsed)
+{
+    void* buffer;
+    expect_transfer(1, buffer);
+    sut_.process_event(init{});
+
+    const std::vector<uint8_t> payload(64, 0xab);
+    uint8_t sequence = 0;
+    for (; sequence < UsartPoint::bulk_blocks; ++sequence)
+    {
+        receive_bulk_frame(buffer, sequence, BulkKind::BufferData, payload);
+    }
+    EXPECT_FALSE(receive_bulk_frame(buffer, sequence, BulkKind::BufferData, payload, false));
+
+    const auto msg = data_.pop();
+    ASSERT_TRUE(msg);
+    EXPECT_EQ(msg->bulk, BulkKind::BufferData);
+    std::vector<uint8_t> expected = link_control(0x15, sequence);
+    const std::vector<uint8_t> ack = link_control(0x06, 0);
+    expected.insert(expected.end(), ack.begin(), ack.end());
+    EXPECT_EQ(msgpu::stubs::usart_output(), expected);
+
+    // block of consumed message is released on next pop, so retransmitted frame fits
+    for (uint8_t i = 1; i < sequence; ++i)
+    {
+        EXPECT_TRUE(data_.pop());
+    }
+    EXPECT_FALSE(data_.pop());
+    EXPECT_TRUE(receive_bulk_frame(buffer, sequence, BulkKind::BufferData, payload));
+    const auto retransmitted = data_.pop();
+    ASSERT_TRUE(retransmitted);
+    EXPECT_EQ(retransmitted->sequence, sequence);
+}
 
+TEST_F(UsartPointShould, GiveAccessToMessageInPlace)
+{
+    void* buffer;
+    expect_transfer(1, buffer);
+    sut_.process_event(init{});
+
+    const Header header {
+        .id = 2,
+        .size = 0,
+    };
+    receive_windowed_frame(buffer, 0, header);
+    receive_windowed_frame(buffer, 1, header);
+
+    const Message* first = data_.peek();
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(first->sequence, 0);
+    // message stays in queue until it is consumed
+    EXPECT_EQ(data_.peek(), first);
+    EXPECT_TRUE(msgpu::stubs::usart_output().empty());
+
+    data_.consume();
+    const Message* second = data_.peek();
+    ASSERT_NE(second, nullptr);
+    EXPECT_NE(second, first);
+    EXPECT_EQ(second->sequence, 1);
+
+    data_.consume();
+    EXPECT_EQ(msgpu::stubs::usart_output(), link_control(0x06, 1));
+    EXPECT_EQ(data_.peek(), nullptr);
+}
+
+TEST_F(UsartPointShould, DropWindowedFramesWhenQueueIsFull)
+{
+    void* buffer;
+    expect_transfer(1, buffer);
+    sut_.process_event(init{});
 
+    const Header header {
+        .id = 2,
+        .size = 0,
+    };
+    uint8_t sequence = 0;
+    for (; sequence < 32; ++sequence)
+    {
+        receive_windowed_frame(buffer, sequence, header);
+    }
+    receive_windowed_frame(buffer, sequence, header);
+
+    ASSERT_NE(data_.peek(), nullptr);
+    EXPECT_EQ(msgpu::stubs::usart_output(), link_control(0x15, sequence));
+    for (uint8_t i = 0; i < sequence; ++i)
+    {
+        ASSERT_NE(data_.peek(), nullptr);
+        data_.consume();
+    }
+    EXPECT_EQ(data_.peek(), nullptr);
+
+    receive_windowed_frame(buffer, sequence, header);
+    const Message* msg = data_.peek();
+    ASSERT_NE(msg, nullptr);
+    EXPECT_EQ(msg->sequence, sequence);
+}
+
+} // namespace msgpu::io
@@ -0,0 +1,160 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <numeric>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "memory/gpuram.hpp"
+#include "memory/psram.hpp"
+#include "qspi_stub.hpp"
+
+namespace msgpu::memory
+{
+
+class GpuRAMShould : public ::testing::Test
+{
+  public:
+    GpuRAMShould()
+        : qspi_(QspiConfig{}, 1.0f)
+        , psram_(qspi_)
+        , sut_(psram_)
+    {
+        stubs::qspi_device().reset();
+    }
+
+    std::vector<stubs::QspiDevice::Command> &commands()
+    {
+        return stubs::qspi_device().commands;
+    }
+
+    static std::vector<uint8_t> pattern(std::size_t size)
+    {
+        std::vector<uint8_t> data(size);
+        std::iota(data.begin(), data.end(), uint8_t{1});
+        return data;
+    }
+
+  protected:
+    Qspi qspi_;
+    QspiPSRAM psram_;
+    GpuRAM sut_;
+};
+
+TEST_F(GpuRAMShould, SplitTransferAtPageBoundaries)
+{
+    const std::vector<uint8_t> data = pattern(3000);
+    EXPECT_EQ(sut_.write(1000, data.data(), data.size()), data.size());
+
+    ASSERT_EQ(commands().size(), 4u);
+    EXPECT_EQ(commands()[0].address, 1000u);
+    EXPECT_EQ(commands()[0].size, 24u);
+    EXPECT_EQ(commands()[1].size, 1024u);
+    EXPECT_EQ(commands()[2].size, 1024u);
+    EXPECT_EQ(commands()[3].address, 3072u);
+    EXPECT_EQ(commands()[3].size, 928u);
+    // all chunks are chained in single burst
+    EXPECT_EQ(stubs::qspi_device().bus_acquisitions, 1u);
+
+    std::vector<uint8_t> readed(data.size());
+    EXPECT_EQ(sut_.read(1000, readed.data(), readed.size()), readed.size());
+    EXPECT_EQ(readed, data);
+}
+
+TEST_F(GpuRAMShould, SkipEmptyChunks)
+{
+    const std::vector<uint8_t> data = pattern(2048);
+    sut_.write(2048, data.data(), data.size());
+    sut_.write(0, data.data(), 0);
+
+    ASSERT_EQ(commands().size(), 2u);
+    EXPECT_EQ(commands()[0].address, 2048u);
+    EXPECT_EQ(commands()[1].address, 3072u);
+}
+
+TEST_F(GpuRAMShould, QueueLongTransferInBursts)
+{
+    const std::vector<uint8_t> data = pattern(QspiPSRAM::max_burst_size * GpuRAM::page_size + 1);
+    sut_.write(0, data.data(), data.size());
+
+    EXPECT_EQ(commands().size(), QspiPSRAM::max_burst_size + 1);
+    EXPECT_EQ(stubs::qspi_device().bus_acquisitions, 2u);
+}
+
+TEST_F(GpuRAMShould, MergeCloseReadsWithinPage)
+{
+    const std::vector<uint8_t> data = pattern(256);
+    sut_.write(512, data.data(), data.size());
+    commands().clear();
+
+    uint8_t a[16];
+    uint8_t b[8];
+    uint8_t c[32];
+    const GpuRAM::ReadRequest requests[] = {
+        {512, a, sizeof(a)},
+        {520, b, sizeof(b)},
+        {560, c, sizeof(c)},
+    };
+    EXPECT_EQ(sut_.read(requests), sizeof(a) + sizeof(b) + sizeof(c));
+
+    ASSERT_EQ(commands().size(), 1u);
+    EXPECT_EQ(commands()[0].address, 512u);
+    EXPECT_EQ(commands()[0].size, 80u);
+    EXPECT_TRUE(std::equal(a, a + sizeof(a), data.begin()));
+    EXPECT_TRUE(std::equal(b, b + sizeof(b), data.begin() + 8));
+    EXPECT_TRUE(std::equal(c, c + sizeof(c), data.begin() + 48));
+}
+
+TEST_F(GpuRAMShould, NotMergeReadsFromDifferentPages)
+{
+    uint8_t a[16];
+    uint8_t b[16];
+    const GpuRAM::ReadRequest requests[] = {
+        {1000, a, sizeof(a)},
+        {1020, b, sizeof(b)},
+    };
+    sut_.read(requests);
+
+    ASSERT_EQ(commands().size(), 3u);
+    EXPECT_EQ(commands()[0].size, 16u);
+    EXPECT_EQ(commands()[1].size, 4u);
+    EXPECT_EQ(commands()[2].address, 1024u);
+}
+
+TEST_F(GpuRAMShould, MergeAdjacentWrites)
+{
+    const std::vector<uint8_t> data = pattern(48);
+    const GpuRAM::WriteRequest requests[] = {
+        {100, data.data(), 16},
+        {116, data.data() + 16, 32},
+        {200, data.data(), 0},
+        {300, data.data(), 8},
+    };
+    EXPECT_EQ(sut_.write(requests), 56u);
+
+    ASSERT_EQ(commands().size(), 2u);
+    EXPECT_EQ(commands()[0].address, 100u);
+    EXPECT_EQ(commands()[0].size, 48u);
+    EXPECT_EQ(commands()[1].address, 300u);
+
+    std::vector<uint8_t> readed(48);
+    sut_.read(100, readed.data(), readed.size());
+    EXPECT_EQ(readed, data);
+}
+
+} // namespace msgpu::memory
@@ -0,0 +1,86 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "memory/line_codec.hpp"
+
+namespace msgpu::memory
+{
+
+namespace
+{
+
+std::vector<uint8_t> round_trip(const std::vector<uint8_t> &line, std::size_t &used)
+{
+    std::vector<uint8_t> slot(encoded_line_capacity(line.size()));
+    used = encode_line(line, slot);
+
+    std::vector<uint8_t> decoded(line.size());
+    EXPECT_TRUE(decode_line(std::span<const uint8_t>(slot).first(used), decoded));
+    return decoded;
+}
+
+} // namespace
+
+TEST(LineCodecShould, CompressFlatLine)
+{
+    const std::vector<uint8_t> line(320, 0x12);
+
+    std::size_t used = 0;
+    EXPECT_EQ(round_trip(line, used), line);
+    // 320 bytes need two runs of at most 256 bytes
+    EXPECT_EQ(used, line_header_size + 4);
+}
+
+TEST(LineCodecShould, StoreRawLineWhenRleDoesntShrinkIt)
+{
+    std::vector<uint8_t> line(64);
+    for (std::size_t i = 0; i < line.size(); ++i)
+    {
+        line[i] = static_cast<uint8_t>(i);
+    }
+
+    std::size_t used = 0;
+    EXPECT_EQ(round_trip(line, used), line);
+    EXPECT_EQ(used, encoded_line_capacity(line.size()));
+}
+
+TEST(LineCodecShould, RestoreMixedRuns)
+{
+    std::vector<uint8_t> line(100, 0xf0);
+    std::fill_n(line.begin() + 10, 30, 0x0f);
+    line[99] = 0xaa;
+
+    std::size_t used = 0;
+    EXPECT_EQ(round_trip(line, used), line);
+    EXPECT_EQ(used, line_header_size + 8);
+}
+
+TEST(LineCodecShould, RejectSlotWithDifferentLineSize)
+{
+    const std::vector<uint8_t> line(32, 0x01);
+    std::vector<uint8_t> slot(encoded_line_capacity(line.size()));
+    const std::size_t used = encode_line(line, slot);
+
+    std::vector<uint8_t> decoded(16);
+    EXPECT_FALSE(decode_line(std::span<const uint8_t>(slot).first(used), decoded));
+}
+
+} // namespace msgpu::memory
@@ -15,12 +15,24 @@
 // along with this program.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "board.hpp"
+#include "board_stubs.hpp"
 
 #include <eul/utils/unused.hpp>
 
 namespace msgpu
 {
 
+namespace stubs
+{
+
+std::vector<uint8_t> &usart_output()
+{
+    static std::vector<uint8_t> output;
+    return output;
+}
+
+} // namespace stubs
+
 void enable_display()
 {
 }
@@ -39,4 +51,14 @@ void sleep_us(uint32_t time)
     UNUSED1(time);
 }
 
+void write_bytes(std::span<const uint8_t> data)
+{
+    stubs::usart_output().insert(stubs::usart_output().end(), data.begin(), data.end());
+}
+
+void write_bytes(const void *data, std::size_t size)
+{
+    write_bytes(std::span<const uint8_t>(static_cast<const uint8_t *>(data), size));
+}
+
 } // namespace msgpu
@@ -35,9 +35,9 @@ void reset_dma_crc()
     hal_dma_mock->reset_dma_crc();
 }
 
-void get_dma_crc()
+uint32_t get_dma_crc()
 {
-    hal_dma_mock->get_dma_crc();
+    return hal_dma_mock->get_dma_crc();
 }
 
 } // namespace hal
@@ -16,6 +16,9 @@
 
 #include "qspi.hpp"
 
+#include "qspi_stub.hpp"
+
+#include <algorithm>
 #include <cstring>
 #include <vector>
 
@@ -24,6 +27,66 @@
 namespace msgpu
 {
 
+namespace stubs
+{
+namespace
+{
+constexpr std::size_t device_size      = 8 * 1024 * 1024;
+constexpr std::size_t device_page_size = 1024;
+} // namespace
+
+QspiDevice::QspiDevice()
+    : memory(device_size, 0)
+    , commands{}
+    , bus_acquisitions(0)
+{
+}
+
+void QspiDevice::reset()
+{
+    std::fill(memory.begin(), memory.end(), 0);
+    commands.clear();
+    bus_acquisitions = 0;
+}
+
+QspiDevice &qspi_device()
+{
+    static QspiDevice device;
+    return device;
+}
+
+namespace
+{
+uint32_t execute(Qspi::ConstDataType command, Qspi::DataType read, Qspi::ConstDataType write)
+{
+    QspiDevice &device = qspi_device();
+    if (command.size() < 4)
+    {
+        return 0;
+    }
+
+    const uint32_t address = static_cast<uint32_t>(command[1] << 16 | command[2] << 8 | command[3]);
+    const std::size_t size = read.empty() ? write.size() : read.size();
+    device.commands.push_back(QspiDevice::Command{command[0], address, size});
+    const std::size_t page = address - address % device_page_size;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        const std::size_t cell = (page + (address + i) % device_page_size) % device.memory.size();
+        if (read.empty())
+        {
+            device.memory[cell] = write[i];
+        }
+        else
+        {
+            read[i] = device.memory[cell];
+        }
+    }
+    return address;
+}
+} // namespace
+
+} // namespace stubs
+
 Qspi::Qspi(const QspiConfig device, float clkdiv)
     : config_(device)
     , clkdiv_(clkdiv)
@@ -70,13 +133,22 @@ bool Qspi::qspi_write(ConstDataType src)
 
 bool Qspi::qspi_command_read(DataType command, DataType data)
 {
-    UNUSED2(command, data);
+    stubs::execute(command, data, {});
     return true;
 }
 
 bool Qspi::qspi_command_write(ConstDataType command, ConstDataType data)
 {
-    UNUSED2(command, data);
+    stubs::execute(command, {}, data);
+    return true;
+}
+
+bool Qspi::qspi_command_write(std::span<const CommandWrite> transfers)
+{
+    for (const CommandWrite &transfer : transfers)
+    {
+        stubs::execute(transfer.command, {}, transfer.data);
+    }
     return true;
 }
 
@@ -86,10 +158,16 @@ void Qspi::wait_for_finish() const
 
 void Qspi::acquire_bus() const
 {
+    ++stubs::qspi_device().bus_acquisitions;
 }
 
 void Qspi::release_bus() const
 {
 }
 
+void Qspi::release_bus_on_finish()
+{
+    release_bus();
+}
+
 } // namespace msgpu
@@ -0,0 +1,49 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace msgpu::stubs
+{
+
+/// @brief PSRAM device behind Qspi stub
+///
+/// @details
+///   Executes read and write commands on memory array, addresses wrap inside 1 KB page
+///   like in real device. Each command is recorded to verify transfer scheduling.
+struct QspiDevice
+{
+    struct Command
+    {
+        uint8_t opcode;
+        uint32_t address;
+        std::size_t size;
+    };
+
+    QspiDevice();
+    void reset();
+
+    std::vector<uint8_t> memory;
+    std::vector<Command> commands;
+    std::size_t bus_acquisitions;
+};
+
+QspiDevice &qspi_device();
+
+} // namespace msgpu::stubs
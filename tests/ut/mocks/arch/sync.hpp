@@ -26,3 +26,9 @@ void mutex_enter_blocking(mutex_t* m);
 
 void mutex_exit(mutex_t* m);
 
+/// @brief Emulates SEV instruction, wakes up every thread waiting in __wfe()
+void __sev();
+
+/// @brief Emulates WFE instruction, returns when event was sent since previous call
+void __wfe();
+
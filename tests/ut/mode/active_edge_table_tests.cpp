@@ -0,0 +1,111 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "mode/active_edge_table.hpp"
+
+namespace msgpu::mode
+{
+
+namespace
+{
+
+using Table = ActiveEdgeTable<240, 32>;
+
+std::vector<uint16_t> visit(Table &table, uint16_t line, uint16_t retire = Table::end_marker)
+{
+    std::vector<uint16_t> ids;
+    table.process_line(line, [&ids, retire](uint16_t id) {
+        ids.push_back(id);
+        return id != retire;
+    });
+    return ids;
+}
+
+} // namespace
+
+TEST(ActiveEdgeTableShould, ActivateTrianglesWhenScanReachesFirstLine)
+{
+    Table sut;
+
+    sut.insert(0, 10);
+    sut.insert(1, 5);
+
+    EXPECT_TRUE(visit(sut, 0).empty());
+    EXPECT_THAT(visit(sut, 5), ::testing::ElementsAre(1));
+    EXPECT_THAT(visit(sut, 9), ::testing::ElementsAre(1));
+    EXPECT_THAT(visit(sut, 10), ::testing::ElementsAre(0, 1));
+}
+
+TEST(ActiveEdgeTableShould, KeepSubmissionOrderForAnyInsertionOrder)
+{
+    Table sut;
+
+    sut.insert(0, 20);
+    sut.insert(1, 0);
+    sut.insert(2, 10);
+    sut.insert(3, 0);
+    sut.insert(4, 20);
+
+    EXPECT_THAT(visit(sut, 0), ::testing::ElementsAre(1, 3));
+    EXPECT_THAT(visit(sut, 10), ::testing::ElementsAre(1, 2, 3));
+    EXPECT_THAT(visit(sut, 20), ::testing::ElementsAre(0, 1, 2, 3, 4));
+}
+
+TEST(ActiveEdgeTableShould, RetireTrianglesFromAnyPosition)
+{
+    Table sut;
+
+    sut.insert(0, 0);
+    sut.insert(1, 0);
+    sut.insert(2, 0);
+
+    EXPECT_THAT(visit(sut, 0, 1), ::testing::ElementsAre(0, 1, 2));
+    EXPECT_THAT(visit(sut, 1, 0), ::testing::ElementsAre(0, 2));
+    EXPECT_THAT(visit(sut, 2, 2), ::testing::ElementsAre(2));
+    EXPECT_TRUE(sut.empty());
+    EXPECT_TRUE(visit(sut, 3).empty());
+}
+
+TEST(ActiveEdgeTableShould, IgnoreTrianglesBelowScreen)
+{
+    Table sut;
+
+    sut.insert(0, 240);
+    for (uint16_t line = 0; line < 240; ++line)
+    {
+        EXPECT_TRUE(visit(sut, line).empty());
+    }
+}
+
+TEST(ActiveEdgeTableShould, DropAllTrianglesOnClear)
+{
+    Table sut;
+
+    sut.insert(0, 0);
+    sut.insert(1, 4);
+    EXPECT_THAT(visit(sut, 0), ::testing::ElementsAre(0));
+
+    sut.clear();
+    EXPECT_TRUE(sut.empty());
+    EXPECT_TRUE(visit(sut, 4).empty());
+}
+
+} // namespace msgpu::mode
@@ -0,0 +1,196 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "mode/clipping.hpp"
+
+namespace msgpu::mode
+{
+
+namespace
+{
+
+screen_vertex v(float x, float y, float z = 0.0f)
+{
+    return screen_vertex{.x = x, .y = y, .z = z};
+}
+
+clip_vertex c(float x, float y, float z, float w = 1.0f)
+{
+    return clip_vertex{.x = x, .y = y, .z = z, .w = w};
+}
+
+} // namespace
+
+TEST(FaceCullingShould, DropTrianglesWithSelectedWinding)
+{
+    const screen_vertex ccw[3] = {v(0, 0), v(10, 0), v(0, 10)};
+    const screen_vertex cw[3]  = {v(0, 0), v(0, 10), v(10, 0)};
+
+    EXPECT_FALSE(is_culled(FaceCulling::None, ccw[0], ccw[1], ccw[2]));
+    EXPECT_FALSE(is_culled(FaceCulling::None, cw[0], cw[1], cw[2]));
+
+    EXPECT_TRUE(is_culled(FaceCulling::CounterClockwise, ccw[0], ccw[1], ccw[2]));
+    EXPECT_FALSE(is_culled(FaceCulling::CounterClockwise, cw[0], cw[1], cw[2]));
+
+    EXPECT_FALSE(is_culled(FaceCulling::Clockwise, ccw[0], ccw[1], ccw[2]));
+    EXPECT_TRUE(is_culled(FaceCulling::Clockwise, cw[0], cw[1], cw[2]));
+}
+
+TEST(FaceCullingShould, DropDegeneratedTriangles)
+{
+    EXPECT_TRUE(is_culled(FaceCulling::None, v(0, 0), v(5, 5), v(10, 10)));
+}
+
+TEST(NearPlaneClipperShould, PassTrianglesInFrontOfNearPlane)
+{
+    const clip_vertex triangle[3] = {c(0, 0, 1), c(1, 0, 2), c(0, 1, 3)};
+    clip_vertex polygon[4];
+
+    ASSERT_EQ(clip_near_plane(triangle, polygon, 0.5f), 3);
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+        EXPECT_FLOAT_EQ(polygon[i].x, triangle[i].x);
+        EXPECT_FLOAT_EQ(polygon[i].y, triangle[i].y);
+        EXPECT_FLOAT_EQ(polygon[i].z, triangle[i].z);
+        EXPECT_FLOAT_EQ(polygon[i].w, triangle[i].w);
+    }
+}
+
+TEST(NearPlaneClipperShould, RejectTrianglesBehindNearPlane)
+{
+    const clip_vertex triangle[3] = {c(0, 0, 1, 0.4f), c(1, 0, 1, 0.0f), c(0, 1, 1, -1.0f)};
+    clip_vertex polygon[4];
+
+    EXPECT_EQ(clip_near_plane(triangle, polygon, 0.5f), 0);
+}
+
+TEST(NearPlaneClipperShould, ClipVertexBehindNearPlaneBeforeDivide)
+{
+    const ViewportClipper viewport(320, 240);
+    const clip_vertex triangle[3] = {c(-1, 0, 0, 0), c(1, 0, 0.5f, 1), c(1, 1, 0.5f, 1)};
+    clip_vertex polygon[4];
+
+    ASSERT_EQ(clip_near_plane(triangle, polygon, 0.5f), 4);
+    for (const auto &vertex : polygon)
+    {
+        EXPECT_GE(vertex.w, 0.5f);
+    }
+
+    // crossing points are in the middle of edges, so they are projected to centre of screen
+    // and to its top edge, not left undivided
+    const screen_vertex top = viewport.project(polygon[0]);
+    EXPECT_FLOAT_EQ(top.x, 159.5f);
+    EXPECT_FLOAT_EQ(top.y, 0.0f);
+    EXPECT_FLOAT_EQ(top.z, 0.5f);
+
+    const screen_vertex centre = viewport.project(polygon[1]);
+    EXPECT_FLOAT_EQ(centre.x, 159.5f);
+    EXPECT_FLOAT_EQ(centre.y, 119.5f);
+
+    const screen_vertex right = viewport.project(polygon[2]);
+    EXPECT_FLOAT_EQ(right.x, 319.0f);
+    EXPECT_FLOAT_EQ(right.y, 119.5f);
+}
+
+TEST(NearPlaneClipperShould, ShrinkTriangleWithTwoVerticesBehindNearPlane)
+{
+    const ViewportClipper viewport(320, 240);
+    const clip_vertex triangle[3] = {c(0, 0, 0.5f, 1), c(2, 0, 0, 0), c(0, 2, 0, 0)};
+    clip_vertex polygon[4];
+
+    ASSERT_EQ(clip_near_plane(triangle, polygon, 0.5f), 3);
+
+    // vertices on near plane are projected twice as far from centre as before divide
+    const screen_vertex above = viewport.project(polygon[0]);
+    EXPECT_FLOAT_EQ(above.x, 159.5f);
+    EXPECT_FLOAT_EQ(above.y, -119.5f);
+
+    const screen_vertex centre = viewport.project(polygon[1]);
+    EXPECT_FLOAT_EQ(centre.x, 159.5f);
+    EXPECT_FLOAT_EQ(centre.y, 119.5f);
+
+    const screen_vertex right = viewport.project(polygon[2]);
+    EXPECT_FLOAT_EQ(right.x, 478.5f);
+    EXPECT_FLOAT_EQ(right.y, 119.5f);
+}
+
+TEST(ViewportClipperShould, PassTrianglesInsideViewport)
+{
+    ViewportClipper sut(320, 240);
+    const screen_vertex triangle[3] = {v(0, 0), v(319, 0), v(0, 239)};
+    ViewportClipper::Polygon polygon;
+
+    ASSERT_EQ(sut.clip(triangle, polygon), 3);
+    EXPECT_FLOAT_EQ(polygon[1].x, 319.0f);
+    EXPECT_FLOAT_EQ(polygon[2].y, 239.0f);
+}
+
+TEST(ViewportClipperShould, RejectTrianglesOutsideViewport)
+{
+    ViewportClipper sut(320, 240);
+    ViewportClipper::Polygon polygon;
+
+    const screen_vertex left[3] = {v(-10, 0), v(-1, 100), v(-50, 200)};
+    EXPECT_EQ(sut.clip(left, polygon), 0);
+
+    const screen_vertex below[3] = {v(0, 240), v(100, 300), v(300, 250)};
+    EXPECT_EQ(sut.clip(below, polygon), 0);
+}
+
+TEST(ViewportClipperShould, ClipTrianglesCrossingViewportEdge)
+{
+    ViewportClipper sut(320, 240);
+    ViewportClipper::Polygon polygon;
+
+    const screen_vertex triangle[3] = {v(-100, 0, 0.0f), v(100, 0, 1.0f), v(100, 100, 1.0f)};
+    const std::size_t size          = sut.clip(triangle, polygon);
+
+    ASSERT_EQ(size, 4);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        EXPECT_GE(polygon[i].x, 0.0f);
+        EXPECT_LE(polygon[i].x, 319.0f);
+        EXPECT_GE(polygon[i].y, 0.0f);
+        EXPECT_LE(polygon[i].y, 239.0f);
+    }
+
+    // depth is interpolated at crossing point
+    EXPECT_FLOAT_EQ(polygon[0].x, 0.0f);
+    EXPECT_FLOAT_EQ(polygon[0].z, 0.5f);
+}
+
+TEST(ViewportClipperShould, ClipTrianglesBiggerThanViewport)
+{
+    ViewportClipper sut(320, 240);
+    ViewportClipper::Polygon polygon;
+
+    const screen_vertex triangle[3] = {v(-1000, -1000), v(2000, -1000), v(-1000, 2000)};
+    const std::size_t size          = sut.clip(triangle, polygon);
+
+    ASSERT_EQ(size, 4);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        EXPECT_GE(polygon[i].x, 0.0f);
+        EXPECT_LE(polygon[i].x, 319.0f);
+        EXPECT_GE(polygon[i].y, 0.0f);
+        EXPECT_LE(polygon[i].y, 239.0f);
+    }
+}
+
+} // namespace msgpu::mode
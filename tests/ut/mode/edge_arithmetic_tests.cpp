@@ -0,0 +1,88 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <type_traits>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "mode/edge_arithmetic.hpp"
+
+namespace msgpu::mode
+{
+
+namespace
+{
+
+struct FloatConfiguration
+{
+};
+
+struct FixedConfiguration
+{
+    constexpr static bool fixed_point_edges = true;
+};
+
+template <typename Edge>
+std::vector<uint16_t> walk_edge(int x0, int y0, int x1, int y1)
+{
+    std::vector<uint16_t> pixels;
+    const typename Edge::Type dx = Edge::slope(x1 - x0, y1 - y0);
+    typename Edge::Type x        = Edge::from_int(x0) + Edge::epsilon;
+    for (int y = y0; y <= y1; ++y)
+    {
+        pixels.push_back(Edge::to_pixel(x));
+        x += dx;
+    }
+    return pixels;
+}
+
+} // namespace
+
+TEST(EdgeArithmeticShould, UseFloatsByDefault)
+{
+    static_assert(std::is_same_v<EdgeArithmetic<FloatConfiguration>, FloatEdgeArithmetic>);
+    static_assert(std::is_same_v<EdgeArithmetic<FixedConfiguration>, FixedEdgeArithmetic>);
+}
+
+TEST(EdgeArithmeticShould, ConvertFixedPointToNearestPixel)
+{
+    EXPECT_EQ(FixedEdgeArithmetic::to_pixel(FixedEdgeArithmetic::from_int(10)), 10);
+    EXPECT_EQ(FixedEdgeArithmetic::to_pixel(FixedEdgeArithmetic::from_int(10) + 0x7fff), 10);
+    EXPECT_EQ(FixedEdgeArithmetic::to_pixel(FixedEdgeArithmetic::from_int(10) + 0x8000), 11);
+    EXPECT_EQ(FixedEdgeArithmetic::to_pixel(-FixedEdgeArithmetic::epsilon), 0);
+}
+
+TEST(EdgeArithmeticShould, ReturnDxForHorizontalEdges)
+{
+    EXPECT_EQ(FixedEdgeArithmetic::slope(-12, 0), FixedEdgeArithmetic::from_int(-12));
+}
+
+TEST(EdgeArithmeticShould, WalkEdgesLikeFloatingPoint)
+{
+    const int edges[][4] = {
+        {0, 0, 319, 239}, {319, 0, 0, 239}, {10, 5, 13, 200}, {200, 17, 100, 18}, {7, 3, 7, 100},
+    };
+
+    for (const auto &e : edges)
+    {
+        EXPECT_EQ(walk_edge<FixedEdgeArithmetic>(e[0], e[1], e[2], e[3]),
+                  walk_edge<FloatEdgeArithmetic>(e[0], e[1], e[2], e[3]));
+    }
+}
+
+} // namespace msgpu::mode
@@ -23,3 +23,8 @@ int main()
 {
     *output = input_a * input_b;
 }
+
+extern "C" void shade_span()
+{
+    *output = input_a - input_b;
+}
@@ -0,0 +1,186 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "memory/gpuram.hpp"
+#include "memory/psram.hpp"
+#include "memory/vram.hpp"
+#include "mode/2d_graphic_mode.hpp"
+#include "qspi_stub.hpp"
+
+namespace msgpu::mode
+{
+
+namespace
+{
+
+constexpr uint8_t psram_write_opcode = 0x38;
+
+struct TestConfiguration
+{
+    constexpr static std::size_t resolution_width  = 320;
+    constexpr static std::size_t resolution_height = 240;
+    constexpr static std::size_t bits_per_pixel    = 8;
+};
+
+struct RamdacStub
+{
+    void write(uint8_t, std::span<const uint8_t>)
+    {
+    }
+
+    void read(std::span<uint8_t> data)
+    {
+        data[0] = 0xac;
+        data[1] = 0x88;
+    }
+};
+
+class GraphicMode2DUnderTest : public GraphicMode2D<TestConfiguration, RamdacStub>
+{
+  public:
+    using GraphicMode2D<TestConfiguration, RamdacStub>::GraphicMode2D;
+
+    Programs &programs()
+    {
+        return this->programs_;
+    }
+};
+
+} // namespace
+
+class GraphicMode2DShould : public ::testing::Test
+{
+  public:
+    GraphicMode2DShould()
+        : qspi_(QspiConfig{}, 1.0f)
+        , psram_(qspi_)
+        , framebuffer_(psram_)
+        , gpuram_(psram_)
+        , sut_(framebuffer_, gpuram_, ramdac_, point_)
+    {
+        stubs::qspi_device().reset();
+        gl_Color = vec4{1.0f, 0.0f, 0.0f, 1.0f};
+    }
+
+    void render_triangle()
+    {
+        sut_.add_triangle(Triangle{.color = 0, .v = {{10, 10}, {100, 10}, {10, 50}}});
+        sut_.render();
+    }
+
+    std::vector<uint8_t> read_line(uint8_t buffer_id, uint16_t line)
+    {
+        std::vector<uint8_t> data(framebuffer_.get_line_size());
+        framebuffer_.read_line(buffer_id, line, std::span<uint8_t>(data));
+        return data;
+    }
+
+    std::vector<stubs::QspiDevice::Command> &commands()
+    {
+        return stubs::qspi_device().commands;
+    }
+
+  protected:
+    Qspi qspi_;
+    memory::QspiPSRAM psram_;
+    memory::VideoRam framebuffer_;
+    memory::GpuRAM gpuram_;
+    RamdacStub ramdac_;
+    io::UsartPoint point_;
+    GraphicMode2DUnderTest sut_;
+};
+
+TEST_F(GraphicMode2DShould, SkipLinesAlreadyStoredInBackBuffer)
+{
+    render_triangle();
+    EXPECT_FALSE(commands().empty());
+
+    commands().clear();
+    render_triangle();
+    EXPECT_TRUE(commands().empty());
+}
+
+TEST_F(GraphicMode2DShould, CopyLinesStoredInFrontBuffer)
+{
+    const uint8_t back_buffer = framebuffer_.get_write_buffer_id();
+    const uint8_t front_buffer = back_buffer ? 0 : 1;
+    render_triangle();
+    const std::vector<uint8_t> rendered = read_line(back_buffer, 20);
+
+    commands().clear();
+    framebuffer_.select_buffer(back_buffer, front_buffer);
+    render_triangle();
+
+    // copied line is read from other buffer, rendered line would be only written
+    EXPECT_TRUE(std::any_of(commands().begin(), commands().end(), [](const auto &command) {
+        return command.opcode != psram_write_opcode;
+    }));
+    EXPECT_EQ(read_line(front_buffer, 20), rendered);
+}
+
+TEST_F(GraphicMode2DShould, RenderLinesAgainWhenFlatColorChanges)
+{
+    const uint8_t back_buffer = framebuffer_.get_write_buffer_id();
+    render_triangle();
+    const std::vector<uint8_t> red = read_line(back_buffer, 20);
+
+    commands().clear();
+    gl_Color = vec4{0.0f, 0.0f, 1.0f, 1.0f};
+    render_triangle();
+
+    EXPECT_FALSE(commands().empty());
+    EXPECT_NE(read_line(back_buffer, 20), red);
+}
+
+TEST_F(GraphicMode2DShould, MarkProgramPixelShaderAsConstant)
+{
+    const uint8_t program_id = sut_.programs().allocate_program();
+    const Program *program   = sut_.programs().get(program_id);
+    ASSERT_NE(program, nullptr);
+
+    EXPECT_TRUE(sut_.set_constant_pixel_shader(program_id, true));
+    EXPECT_TRUE(program->constant_pixel_shader());
+
+    EXPECT_TRUE(sut_.set_constant_pixel_shader(program_id, false));
+    EXPECT_FALSE(program->constant_pixel_shader());
+}
+
+TEST_F(GraphicMode2DShould, RejectConstantPixelShaderForNotAllocatedProgram)
+{
+    EXPECT_FALSE(sut_.set_constant_pixel_shader(3, true));
+}
+
+#if MSGPU_CONSTANT_PIXEL_SHADER_MESSAGE
+TEST_F(GraphicMode2DShould, MarkPixelShaderAsConstantFromMessage)
+{
+    const uint8_t program_id = sut_.programs().allocate_program();
+
+    sut_.process(SetConstantPixelShader{.program_id = program_id, .constant = 1});
+    EXPECT_TRUE(sut_.programs().get(program_id)->constant_pixel_shader());
+
+    sut_.process(SetConstantPixelShader{.program_id = program_id, .constant = 0});
+    EXPECT_FALSE(sut_.programs().get(program_id)->constant_pixel_shader());
+}
+#endif // MSGPU_CONSTANT_PIXEL_SHADER_MESSAGE
+
+} // namespace msgpu::mode
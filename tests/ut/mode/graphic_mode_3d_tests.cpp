@@ -0,0 +1,174 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <cstdint>
+#include <span>
+
+#include <gtest/gtest.h>
+
+#include "memory/gpuram.hpp"
+#include "memory/psram.hpp"
+#include "memory/vram.hpp"
+#include "mode/3d_graphic_mode.hpp"
+#include "qspi_stub.hpp"
+
+namespace msgpu::mode
+{
+
+namespace
+{
+
+struct TestConfiguration
+{
+    constexpr static std::size_t resolution_width  = 320;
+    constexpr static std::size_t resolution_height = 240;
+    constexpr static std::size_t bits_per_pixel    = 8;
+};
+
+struct RamdacStub
+{
+    void write(uint8_t, std::span<const uint8_t>)
+    {
+    }
+
+    void read(std::span<uint8_t> data)
+    {
+        data[0] = 0xac;
+        data[1] = 0x88;
+    }
+};
+
+class GraphicMode3DUnderTest : public GraphicMode3D<TestConfiguration, RamdacStub>
+{
+  public:
+    using GraphicMode3D<TestConfiguration, RamdacStub>::GraphicMode3D;
+
+    uint16_t generate_vertex_array()
+    {
+        uint16_t id;
+        this->vertex_array_buffer_.allocate_names(1, &id);
+        return static_cast<uint16_t>(id + 1);
+    }
+
+    const VertexAttribute *attributes() const
+    {
+        return this->vertex_attributes_;
+    }
+
+    const VertexAttribute *default_attributes() const
+    {
+        return this->default_array_.attributes;
+    }
+};
+
+} // namespace
+
+class GraphicMode3DShould : public ::testing::Test
+{
+  public:
+    GraphicMode3DShould()
+        : qspi_(QspiConfig{}, 1.0f)
+        , psram_(qspi_)
+        , framebuffer_(psram_)
+        , gpuram_(psram_)
+        , sut_(framebuffer_, gpuram_, ramdac_, point_)
+    {
+        stubs::qspi_device().reset();
+    }
+
+    void bind_vertex_array(uint16_t name)
+    {
+        BindObject msg{};
+        msg.type      = BindObjectType::BindVertexArray;
+        msg.object_id = name;
+        sut_.process(msg);
+    }
+
+    void set_position_attribute()
+    {
+        SetVertexAttrib msg{};
+        msg.index  = 0;
+        msg.size   = 3;
+        msg.stride = 3 * sizeof(float);
+        sut_.process(msg);
+    }
+
+    void draw_triangle()
+    {
+        DrawArrays msg{};
+        msg.first = 0;
+        msg.count = 3;
+        sut_.process(msg);
+        sut_.render();
+    }
+
+  protected:
+    Qspi qspi_;
+    memory::QspiPSRAM psram_;
+    memory::VideoRam framebuffer_;
+    memory::GpuRAM gpuram_;
+    RamdacStub ramdac_;
+    io::UsartPoint point_;
+    GraphicMode3DUnderTest sut_;
+};
+
+TEST_F(GraphicMode3DShould, BindDefaultArrayWhenBoundArrayIsDeleted)
+{
+    const uint16_t array = sut_.generate_vertex_array();
+    bind_vertex_array(array);
+    set_position_attribute();
+    EXPECT_NE(sut_.attributes(), sut_.default_attributes());
+    EXPECT_TRUE(sut_.attributes()[0].used);
+
+    const uint16_t names[] = {array};
+    sut_.delete_names(ObjectType::VertexArray, names);
+    EXPECT_EQ(sut_.attributes(), sut_.default_attributes());
+
+    // slot of deleted array is reused by new array, state used for drawing stays default
+    bind_vertex_array(sut_.generate_vertex_array());
+    set_position_attribute();
+    bind_vertex_array(0);
+
+    draw_triangle();
+    EXPECT_EQ(sut_.attributes(), sut_.default_attributes());
+    EXPECT_FALSE(sut_.attributes()[0].used);
+}
+
+TEST_F(GraphicMode3DShould, ModifyDefaultArrayAfterBoundArrayIsDeleted)
+{
+    const uint16_t array = sut_.generate_vertex_array();
+    bind_vertex_array(array);
+
+    const uint16_t names[] = {array};
+    sut_.delete_names(ObjectType::VertexArray, names);
+    set_position_attribute();
+
+    EXPECT_TRUE(sut_.default_attributes()[0].used);
+}
+
+TEST_F(GraphicMode3DShould, CountVertexCacheStatisticsPerFrame)
+{
+    draw_triangle();
+    const std::size_t misses = sut_.vertex_cache().misses();
+    const std::size_t hits   = sut_.vertex_cache().hits();
+    EXPECT_NE(misses, 0);
+
+    sut_.render();
+    EXPECT_EQ(sut_.vertex_cache().misses(), misses);
+    EXPECT_EQ(sut_.vertex_cache().hits(), hits);
+}
+
+} // namespace msgpu::mode
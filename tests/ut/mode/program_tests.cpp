@@ -47,6 +47,16 @@ TEST(ProgramShould, AssignShaders)
     EXPECT_THAT(sut.pixel_shader(), ::testing::Pointer(&m2));
 }
 
+TEST(ProgramShould, MarkPixelShaderAsConstant)
+{
+    Program sut;
+    EXPECT_FALSE(sut.constant_pixel_shader());
+    sut.set_constant_pixel_shader(true);
+    EXPECT_TRUE(sut.constant_pixel_shader());
+    sut.set_constant_pixel_shader(false);
+    EXPECT_FALSE(sut.constant_pixel_shader());
+}
+
 TEST(ProgramShould, ReturnsIdOfParameter)
 {
     Program sut;
@@ -123,4 +123,50 @@ TEST_F(ProgramsShould, AddShaders)
     EXPECT_EQ(answer, input_a * input_b);
 }
 
+TEST_F(ProgramsShould, ResolveSpanEntryPointOfPixelShader)
+{
+    const uint8_t program_id = sut_.allocate_program();
+    EXPECT_EQ(sut_.get(program_id)->span_shader(), nullptr);
+
+    const uint8_t vertex_shader_id = sut_.allocate_vertex_shader();
+    sut_.add_shader(vertex_shader_id, load_module(VERTEX_SHADER_PATH));
+    sut_.assign_module(program_id, vertex_shader_id);
+    EXPECT_EQ(sut_.get(program_id)->span_shader(), nullptr);
+
+    const uint8_t fragment_shader_id = sut_.allocate_fragment_shader();
+    sut_.add_shader(fragment_shader_id, load_module(FRAGMENT_SHADER_PATH));
+    sut_.assign_module(program_id, fragment_shader_id);
+    ASSERT_NE(sut_.get(program_id)->span_shader(), nullptr);
+
+    input_a = 120;
+    input_b = 8;
+    int answer;
+    output = &answer;
+    sut_.get(program_id)->span_shader()();
+    EXPECT_EQ(answer, input_a - input_b);
+}
+
+TEST_F(ProgramsShould, ResolveBatchEntryPointOfVertexShader)
+{
+    const uint8_t program_id = sut_.allocate_program();
+    EXPECT_EQ(sut_.get(program_id)->vertex_batch_shader(), nullptr);
+
+    const uint8_t fragment_shader_id = sut_.allocate_fragment_shader();
+    sut_.add_shader(fragment_shader_id, load_module(FRAGMENT_SHADER_PATH));
+    sut_.assign_module(program_id, fragment_shader_id);
+    EXPECT_EQ(sut_.get(program_id)->vertex_batch_shader(), nullptr);
+
+    const uint8_t vertex_shader_id = sut_.allocate_vertex_shader();
+    sut_.add_shader(vertex_shader_id, load_module(VERTEX_SHADER_PATH));
+    sut_.assign_module(program_id, vertex_shader_id);
+    ASSERT_NE(sut_.get(program_id)->vertex_batch_shader(), nullptr);
+
+    input_a = 10;
+    input_b = 25;
+    int answer;
+    output = &answer;
+    sut_.get(program_id)->vertex_batch_shader()();
+    EXPECT_EQ(answer, input_a * 2 + input_b);
+}
+
 } // namespace msgpu::mode
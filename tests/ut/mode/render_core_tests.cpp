@@ -0,0 +1,91 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "mode/render_core.hpp"
+
+namespace msgpu::mode
+{
+
+TEST(RenderCoreShould, ExecuteJobsInSubmissionOrder)
+{
+    RenderCore sut;
+    std::vector<int> executed;
+
+    EXPECT_TRUE(sut.idle());
+    sut.submit([&executed] { executed.push_back(1); });
+    sut.submit([&executed] { executed.push_back(2); });
+    EXPECT_FALSE(sut.idle());
+
+    EXPECT_TRUE(sut.process_job());
+    EXPECT_TRUE(sut.process_job());
+    EXPECT_FALSE(sut.process_job());
+
+    EXPECT_TRUE(sut.idle());
+    EXPECT_EQ(executed, (std::vector<int>{1, 2}));
+}
+
+TEST(RenderCoreShould, NotWaitWhenAllowedNumberOfJobsIsPending)
+{
+    RenderCore sut;
+    int executed = 0;
+
+    sut.submit([&executed] { ++executed; });
+    sut.wait_for_pending(1);
+    EXPECT_EQ(executed, 0);
+
+    sut.process_job();
+    sut.wait_idle();
+    EXPECT_EQ(executed, 1);
+}
+
+TEST(RenderCoreShould, ExecuteJobsOnOtherCore)
+{
+    RenderCore sut;
+    std::atomic<bool> stop{false};
+    std::thread render_core([&sut, &stop] {
+        while (!stop)
+        {
+            sut.process_job();
+        }
+    });
+
+    constexpr int jobs = 100;
+    int last_job       = -1;
+    bool ordered       = true;
+    for (int i = 0; i < jobs; ++i)
+    {
+        // submit blocks when queue is full, so jobs are executed while next ones are queued
+        sut.submit([i, &last_job, &ordered] {
+            ordered  = ordered && last_job + 1 == i;
+            last_job = i;
+        });
+    }
+    sut.wait_idle();
+
+    EXPECT_TRUE(ordered);
+    EXPECT_EQ(last_job, jobs - 1);
+
+    stop = true;
+    render_core.join();
+}
+
+} // namespace msgpu::mode
@@ -0,0 +1,218 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "mode/vertex_batch.hpp"
+
+namespace msgpu::mode
+{
+
+namespace
+{
+
+struct BuffersStub
+{
+    struct Read
+    {
+        uint32_t id;
+        std::size_t size;
+        std::size_t offset;
+    };
+
+    void read(uint32_t id, void *data, std::size_t size, std::size_t offset)
+    {
+        reads.push_back(Read{.id = id, .size = size, .offset = offset});
+        std::memcpy(data, memory.data() + offset, size);
+    }
+
+    std::vector<uint8_t> memory;
+    std::vector<Read> reads;
+};
+
+struct GatheringBuffersStub : BuffersStub
+{
+    struct BufferRead
+    {
+        uint32_t id;
+        void *data;
+        std::size_t size;
+        std::size_t offset;
+    };
+
+    using BuffersStub::read;
+
+    void read(std::span<const BufferRead> requests)
+    {
+        ++gathers;
+        for (const BufferRead &r : requests)
+        {
+            read(r.id, r.data, r.size, r.offset);
+        }
+    }
+
+    std::size_t gathers = 0;
+};
+
+BuffersStub create_buffers(std::size_t floats)
+{
+    BuffersStub buffers;
+    buffers.memory.resize(floats * sizeof(float));
+    for (std::size_t i = 0; i < floats; ++i)
+    {
+        const float value = static_cast<float>(i);
+        std::memcpy(buffers.memory.data() + i * sizeof(float), &value, sizeof(float));
+    }
+    return buffers;
+}
+
+VertexAttribute attribute(uint16_t buffer, uint16_t size, uint32_t stride, uint32_t offset)
+{
+    VertexAttribute a{};
+    a.size   = size & 0x3;
+    a.used   = true;
+    a.buffer = buffer;
+    a.stride = stride;
+    a.offset = offset;
+    return a;
+}
+
+float argument(void *argument, std::size_t element)
+{
+    float value;
+    std::memcpy(&value, static_cast<uint8_t *>(argument) + element * sizeof(float), sizeof(float));
+    return value;
+}
+
+} // namespace
+
+TEST(VertexBatchShould, LoadPackedAttributeWithSingleRead)
+{
+    VertexBatch<16> sut;
+    BuffersStub buffers = create_buffers(128);
+    VertexAttribute attributes[shader_in_arguments_size]{};
+    attributes[0] = attribute(3, 3, 0, 0);
+
+    sut.load(buffers, attributes, 2, 10);
+
+    ASSERT_EQ(sut.size(), 10);
+    ASSERT_EQ(buffers.reads.size(), 1);
+    EXPECT_EQ(buffers.reads[0].id, 3);
+    EXPECT_EQ(buffers.reads[0].size, 10 * 3 * sizeof(float));
+    EXPECT_EQ(buffers.reads[0].offset, 2 * 3 * sizeof(float));
+
+    void *arguments[shader_in_arguments_size];
+    sut.set_arguments(4, arguments);
+    EXPECT_FLOAT_EQ(argument(arguments[0], 0), 18.0f);
+    EXPECT_FLOAT_EQ(argument(arguments[0], 2), 20.0f);
+}
+
+TEST(VertexBatchShould, SplitInterleavedAttributesIntoStreams)
+{
+    VertexBatch<16> sut;
+    BuffersStub buffers = create_buffers(128);
+    VertexAttribute attributes[shader_in_arguments_size]{};
+    // position (3 floats) and colour (2 floats) interleaved
+    attributes[0] = attribute(1, 3, 5 * sizeof(float), 0);
+    attributes[1] = attribute(1, 2, 5 * sizeof(float), 3 * sizeof(float));
+
+    sut.load(buffers, attributes, 0, 16);
+
+    EXPECT_EQ(buffers.reads.size(), 2);
+
+    void *arguments[shader_in_arguments_size];
+    for (std::size_t vertex = 0; vertex < 16; ++vertex)
+    {
+        sut.set_arguments(vertex, arguments);
+        EXPECT_FLOAT_EQ(argument(arguments[0], 0), static_cast<float>(vertex * 5));
+        EXPECT_FLOAT_EQ(argument(arguments[0], 2), static_cast<float>(vertex * 5 + 2));
+        EXPECT_FLOAT_EQ(argument(arguments[1], 0), static_cast<float>(vertex * 5 + 3));
+        EXPECT_FLOAT_EQ(argument(arguments[1], 1), static_cast<float>(vertex * 5 + 4));
+    }
+}
+
+TEST(VertexBatchShould, SplitLongStridesIntoFewReads)
+{
+    VertexBatch<16> sut;
+    BuffersStub buffers = create_buffers(16 * 128);
+    VertexAttribute attributes[shader_in_arguments_size]{};
+    attributes[0] = attribute(0, 1, 400, 8);
+
+    sut.load(buffers, attributes, 1, 16);
+
+    EXPECT_EQ(buffers.reads.size(), 6);
+
+    void *arguments[shader_in_arguments_size];
+    for (std::size_t vertex = 0; vertex < 16; ++vertex)
+    {
+        sut.set_arguments(vertex, arguments);
+        EXPECT_FLOAT_EQ(argument(arguments[0], 0), static_cast<float>((vertex + 1) * 100 + 2));
+    }
+}
+
+#if MSGPU_SHADER_VERTEX_BATCH
+TEST(VertexBatchShould, ProvideDescriptorForBatchedShader)
+{
+    VertexBatch<16> sut;
+    BuffersStub buffers = create_buffers(128);
+    VertexAttribute attributes[shader_in_arguments_size]{};
+    attributes[0] = attribute(0, 2, 0, 0);
+
+    sut.load(buffers, attributes, 0, 7);
+    const ShaderVertexBatch batch = sut.descriptor();
+
+    EXPECT_EQ(batch.count, 7);
+    EXPECT_EQ(batch.input_sizes[0], 2 * sizeof(float));
+    EXPECT_EQ(batch.positions, sut.positions);
+    EXPECT_EQ(batch.colors, sut.colors);
+    EXPECT_FLOAT_EQ(argument(batch.inputs[0], 3), 3.0f);
+}
+#endif // MSGPU_SHADER_VERTEX_BATCH
+
+TEST(VertexBatchShould, GatherPackedAttributesInSingleRequest)
+{
+    VertexBatch<16> sut;
+    GatheringBuffersStub buffers;
+    static_cast<BuffersStub &>(buffers) = create_buffers(256);
+    VertexAttribute attributes[shader_in_arguments_size]{};
+    attributes[0] = attribute(1, 3, 0, 0);
+    attributes[1] = attribute(2, 2, 2 * sizeof(float), 128 * sizeof(float));
+    // interleaved attribute is still read through scratch
+    attributes[2] = attribute(3, 1, 4 * sizeof(float), 0);
+
+    sut.load(buffers, attributes, 1, 8);
+
+    EXPECT_EQ(buffers.gathers, 1);
+    ASSERT_EQ(buffers.reads.size(), 3);
+    EXPECT_EQ(buffers.reads[0].id, 3);
+    EXPECT_EQ(buffers.reads[1].id, 1);
+    EXPECT_EQ(buffers.reads[1].offset, 3 * sizeof(float));
+    EXPECT_EQ(buffers.reads[2].id, 2);
+    EXPECT_EQ(buffers.reads[2].size, 8 * 2 * sizeof(float));
+
+    void *arguments[shader_in_arguments_size];
+    sut.set_arguments(2, arguments);
+    EXPECT_FLOAT_EQ(argument(arguments[0], 0), 9.0f);
+    EXPECT_FLOAT_EQ(argument(arguments[1], 1), 135.0f);
+    EXPECT_FLOAT_EQ(argument(arguments[2], 0), 12.0f);
+}
+
+} // namespace msgpu::mode
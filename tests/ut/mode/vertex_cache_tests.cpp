@@ -0,0 +1,95 @@
+// This file is part of msgpu project.
+// Copyright (C) 2021 Mateusz Stadnik
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include "mode/vertex_cache.hpp"
+
+namespace msgpu::mode
+{
+
+namespace
+{
+
+TransformedVertex vertex(float x, float y, uint16_t color)
+{
+    return TransformedVertex{
+        .position = clip_vertex{.x = x, .y = y, .z = 0.0f, .w = 1.0f},
+        .color    = color,
+    };
+}
+
+} // namespace
+
+TEST(VertexCacheShould, ReturnInsertedVertices)
+{
+    VertexCache<16> sut;
+    EXPECT_EQ(sut.find(1, 10), nullptr);
+
+    sut.insert(1, 10, vertex(5, 6, 7));
+    const TransformedVertex *v = sut.find(1, 10);
+    ASSERT_NE(v, nullptr);
+    EXPECT_FLOAT_EQ(v->position.x, 5.0f);
+    EXPECT_FLOAT_EQ(v->position.y, 6.0f);
+    EXPECT_EQ(v->color, 7);
+}
+
+TEST(VertexCacheShould, DistinguishBuffers)
+{
+    VertexCache<16> sut;
+    sut.insert(1, 10, vertex(5, 6, 7));
+    EXPECT_EQ(sut.find(2, 10), nullptr);
+    EXPECT_FALSE(sut.contains(2, 10));
+    EXPECT_TRUE(sut.contains(1, 10));
+}
+
+TEST(VertexCacheShould, EvictConflictingVertex)
+{
+    VertexCache<16> sut;
+    sut.insert(1, 10, vertex(5, 6, 7));
+    sut.insert(1, 26, vertex(1, 2, 3));
+    EXPECT_EQ(sut.find(1, 10), nullptr);
+    ASSERT_NE(sut.find(1, 26), nullptr);
+}
+
+TEST(VertexCacheShould, CountHitsAndMisses)
+{
+    VertexCache<16> sut;
+    sut.insert(0, 1, vertex(1, 1, 1));
+    sut.insert(0, 2, vertex(2, 2, 2));
+    sut.find(0, 1);
+    sut.find(0, 1);
+    sut.find(0, 3);
+    sut.contains(0, 2);
+
+    EXPECT_EQ(sut.hits(), 2);
+    EXPECT_EQ(sut.misses(), 2);
+
+    sut.reset_statistics();
+    EXPECT_EQ(sut.hits(), 0);
+    EXPECT_EQ(sut.misses(), 0);
+}
+
+TEST(VertexCacheShould, DropVerticesOnClear)
+{
+    VertexCache<16> sut;
+    sut.insert(0, 1, vertex(1, 1, 1));
+    sut.clear();
+    EXPECT_EQ(sut.find(0, 1), nullptr);
+}
+
+} // namespace msgpu::mode
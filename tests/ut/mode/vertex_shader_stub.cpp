@@ -22,4 +22,9 @@ extern int *output;
 int main()
 {
     *output = input_a + input_b;
+}
+
+extern "C" void shade_vertices()
+{
+    *output = input_a * 2 + input_b;
 }
\ No newline at end of file
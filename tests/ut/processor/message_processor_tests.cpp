@@ -109,5 +109,45 @@ TEST(MessageProcessorShould, RegisterMessages)
     sut.process_message(msg_c);
 }
 
+struct BulkHandler
+{
+    MOCK_METHOD1(process_buffer_data, bool(const io::BufferDataBlock& block));
+    MOCK_METHOD1(process_program_data, bool(const io::ProgramDataBlock& block));
+};
+
+TEST(MessageProcessorShould, DispatchBulkData)
+{
+    MessageProcessor sut;
+    BulkHandler mock;
+
+    sut.register_bulk_handler<io::BufferDataBlock>(&BulkHandler::process_buffer_data, &mock);
+    sut.register_bulk_handler<io::ProgramDataBlock>(&BulkHandler::process_program_data, &mock);
+
+    const uint8_t data[] = {1, 2, 3, 4, 5};
+
+    EXPECT_CALL(mock, process_buffer_data(::testing::_))
+        .WillOnce(::testing::Invoke([&data](const io::BufferDataBlock& block) {
+            EXPECT_EQ(block.data.data(), data);
+            EXPECT_EQ(block.data.size(), sizeof(data));
+            return true;
+        }));
+    EXPECT_CALL(mock, process_program_data(::testing::_)).Times(0);
+
+    io::Message msg {
+        .received = true,
+        .header = {
+            .id = A::id,
+            .size = 0
+        },
+        .payload = {},
+        .windowed = true,
+        .sequence = 0,
+        .bulk = io::BulkKind::BufferData,
+        .bulk_data = std::span<const uint8_t>(data)
+    };
+
+    sut.process_message(msg);
+}
+
 } // namespace msgpu::processor
 